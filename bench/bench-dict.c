@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench-dict.c
+ *
+ * @brief Dict lookup latency benchmark.
+ *
+ * Usage: bench-dict [LOOKUPS]
+ *
+ * For a range of sizes, fill a dict of every engine and hash function
+ * and measure the average time of a lookup, for keys present in random
+ * order and for missing keys.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "json.h"
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+static size_t fnv_hash(JSON_HashKey key)
+{
+  size_t hash = 0xcbf29ce484222325;
+
+  while (*key)
+    hash = (hash ^ (unsigned char)*key++) * 0x100000001b3;
+
+  return hash;
+}
+
+
+
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+
+
+/**
+ * @brief Time lookups of keys in a dict.
+ *
+ * @return The average time of a lookup, in nanoseconds.
+ */
+static double time_lookups(const JSON_Dict* dict, char** keys, const size_t* order,
+                           size_t lookups, size_t* found)
+{
+  double start = now();
+
+  for (size_t i=0; i < lookups; ++i)
+    *found += JSON_GetDictValue(keys[order[i]], dict) != NULL;
+
+  return (now() - start) / lookups * 1e9;
+}
+
+
+
+
+int main(int argc, char* argv[])
+{
+  static const size_t sizes[] = {8, 64, 512, 4096, 32768, 262144, 1048576};
+
+  static const char* names[] = {"chained", "open"};
+
+  static const struct { const char* name; JSON_HashFunc fn; } hashes[] =
+  {
+    {"fnv-1a",  fnv_hash},
+    {"default", NULL}
+  };
+
+  size_t lookups = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+  size_t found   = 0;
+  size_t max     = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+
+  char**  keys   = malloc(2 * max * sizeof(char*));
+  size_t* order  = malloc(lookups * sizeof(size_t));
+
+  if (keys == NULL || order == NULL)
+  {
+    perror("malloc");
+    return 1;
+  }
+
+  /*  The second half of the keys are never inserted  */
+  for (size_t i=0; i < 2 * max; ++i)
+  {
+    char key[32];
+
+    snprintf(key, sizeof(key), "key-%zu", i);
+    keys[i] = strdup(key);
+  }
+
+  printf("%10s %10s %10s %12s %12s\n",
+         "entries", "engine", "hash", "hit (ns)", "miss (ns)");
+
+  srand(42);
+  JSON_SetHashSeed(42);
+
+  for (size_t s=0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+  {
+    size_t n = sizes[s];
+
+    for (size_t h=0; h < sizeof(hashes) / sizeof(hashes[0]); ++h)
+    {
+      for (JSON_DictEngine engine = JSON_DICT_CHAINED; engine <= JSON_DICT_OPEN; ++engine)
+      {
+        JSON_Dict* dict = JSON_MallocDictEngine(NULL, JSON_DICT_MIN_SIZE, hashes[h].fn, engine);
+
+        for (size_t i=0; i < n; ++i)
+        {
+          JSON_Type* value = JSON_MallocType(keys[i], JSON_NONE);
+
+          JSON_SetDictValue(dict, value);
+        }
+
+        for (size_t i=0; i < lookups; ++i)
+          order[i] = (size_t)rand() % n;
+
+        double hit = time_lookups(dict, keys, order, lookups, &found);
+
+        for (size_t i=0; i < lookups; ++i)
+          order[i] += max;
+
+        double miss = time_lookups(dict, keys, order, lookups, &found);
+
+        printf("%10zu %10s %10s %12.1f %12.1f\n",
+               n, names[engine], hashes[h].name, hit, miss);
+
+        JSON_FreeDict(dict);
+      }
+    }
+  }
+
+  for (size_t i=0; i < 2 * max; ++i)
+    free(keys[i]);
+
+  free(keys);
+  free(order);
+
+  return found == 0;
+}
@@ -0,0 +1,332 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench-parse.c
+ *
+ * @brief Parsing throughput benchmark.
+ *
+ * Usage: bench-parse FILE [ROUNDS] [stream|mmap|index|document|insitu|tape|cursor|events|build|records|parallel|array]
+ *
+ * Every round is timed from the start of the parse to the release of
+ * the tree. In insitu mode, the file is read in a writable buffer
+ * before the clock starts. In cursor mode, nothing is parsed but the
+ * "id" of every element of the root list, on demand. In events mode,
+ * the integers are summed from the events, and no tree is built. In
+ * records mode, the file is read as JSON Lines into one document; in
+ * parallel mode, on one thread per processor, in order. In array mode,
+ * the root list is parsed on JSON_THREADS threads, one per processor
+ * by default.
+ *
+ * The parse functions use the engine named by JSON_ENGINE, bison or
+ * descent, or the default one.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cursor.h"
+#include "descent.h"
+#include "document.h"
+#include "index.h"
+#include "json.h"
+#include "parallel.h"
+#include "parser.h"
+#include "records.h"
+#include "sax.h"
+#include "tape.h"
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+static int parse_indexed(JSON_Type** type, const char* path)
+{
+  JSON_Reader reader;
+
+  if (JSON_OpenReader(&reader, path) != 0)
+    return -1;
+
+  JSON_Index* index = JSON_MallocIndex(reader.cursor,
+                                       reader.limit - reader.cursor);
+
+  if (index == NULL || JSON_IndexReader(&reader, index) != 0)
+  {
+    JSON_FreeIndex(index);
+    JSON_CloseReader(&reader);
+    return -1;
+  }
+
+  int retval = JSON_ParseReader(type, &reader, NULL, JSON_DICT_MIN_SIZE, 64);
+
+  JSON_FreeIndex(index);
+  JSON_CloseReader(&reader);
+
+  return retval;
+}
+
+
+
+
+static int parse_cursor(const char* path, int64_t* sum)
+{
+  JSON_Reader reader;
+  JSON_Cursor root;
+  JSON_Cursor element = {NULL};
+
+  if (JSON_OpenReader(&reader, path) != 0)
+    return -1;
+
+  if (JSON_OpenCursor(&root, reader.cursor, reader.limit - reader.cursor) != 0)
+  {
+    JSON_CloseReader(&reader);
+    return -1;
+  }
+
+  while (JSON_CursorNext(&root, &element) == 0)
+  {
+    JSON_Cursor id;
+    JSON_Number number;
+
+    if (JSON_CursorGet(&element, "id", &id) == 0 && JSON_CursorNumber(&id, &number) == 0)
+      *sum += number.integer;
+  }
+
+  JSON_CloseReader(&reader);
+
+  return 0;
+}
+
+
+
+
+static int sum_number(void* ctx, const JSON_Number* num)
+{
+  if (num->type == JSON_INTEGER)
+    *(int64_t*)ctx += num->integer;
+
+  return 0;
+}
+
+
+
+
+static int parse_events(JSON_Type** type, const char* path, int64_t* sum)
+{
+  JSON_Reader  reader;
+  JSON_Handler handler = {.number = sum_number, .ctx = sum};
+
+  if (JSON_OpenReader(&reader, path) != 0)
+    return -1;
+
+  int retval = sum ? JSON_ParseEvents(&reader, &handler)
+                   : JSON_BuildReader(type, &reader, NULL, NULL, JSON_DICT_MIN_SIZE, 64);
+
+  JSON_CloseReader(&reader);
+
+  return retval;
+}
+
+
+
+
+static int parse_array(JSON_Type** type, const char* path)
+{
+  JSON_Reader reader;
+  const char* threads = getenv("JSON_THREADS");
+
+  if (JSON_OpenReader(&reader, path) != 0)
+    return -1;
+
+  int retval = JSON_ParseArrayParallel(type, &reader, threads ? atoi(threads) : 0,
+                                       NULL, JSON_DICT_MIN_SIZE, 64);
+
+  JSON_CloseReader(&reader);
+
+  return retval;
+}
+
+
+
+
+static int count_record(JSON_Document* record, void* ctx)
+{
+  ++*(int64_t*)ctx;
+
+  return 0;
+}
+
+
+
+
+static int parse_records(JSON_Document* doc, const char* path, int64_t* sum)
+{
+  JSON_Reader reader;
+
+  if (JSON_OpenReader(&reader, path) != 0)
+    return -1;
+
+  int retval = doc ? JSON_ParseRecords(doc, &reader, count_record, sum, NULL,
+                                       JSON_DICT_MIN_SIZE, 64)
+                   : JSON_ParseRecordsParallel(&reader, count_record, sum, 0, 1, NULL,
+                                               JSON_DICT_MIN_SIZE, 64);
+
+  JSON_CloseReader(&reader);
+
+  return retval;
+}
+
+
+
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: %s FILE [ROUNDS] [stream|mmap|index|document|insitu|tape|cursor|events|build|records|parallel|array]\n", argv[0]);
+    return 1;
+  }
+
+  int    rounds = argc > 2 ? atoi(argv[2]) : 5;
+  const char* mode = argc > 3 ? argv[3] : "stream";
+  double best   = 0;
+  long   size   = 0;
+  int64_t sum   = 0;
+
+  const char* engine = getenv("JSON_ENGINE");
+
+  if (engine)
+    JSON_SetParserEngine(strcmp(engine, "descent") == 0 ? JSON_PARSER_DESCENT
+                                                        : JSON_PARSER_BISON);
+
+  JSON_Document* doc  = JSON_MallocDocument();
+  JSON_Tape*     tape = JSON_MallocTape();
+
+  if (doc == NULL || tape == NULL)
+  {
+    perror("JSON_MallocDocument");
+    return 1;
+  }
+
+  for (int i=0; i < rounds; ++i)
+  {
+    JSON_Type* type = NULL;
+    FILE*      in   = fopen(argv[1], "r");
+
+    if (!in)
+    {
+      perror(argv[1]);
+      return 1;
+    }
+
+    fseek(in, 0, SEEK_END);
+    size = ftell(in);
+    rewind(in);
+
+    char* buf = NULL;
+
+    if (strcmp(mode, "insitu") == 0)
+    {
+      buf = malloc(size);
+
+      if (buf == NULL || fread(buf, 1, size, in) != (size_t)size)
+      {
+        perror(argv[1]);
+        return 1;
+      }
+    }
+
+    double start = now();
+
+    int retval;
+
+    if (strcmp(mode, "mmap") == 0)
+      retval = JSON_ParseFile(&type, argv[1], NULL, JSON_DICT_MIN_SIZE, 64);
+    else if (strcmp(mode, "index") == 0)
+      retval = parse_indexed(&type, argv[1]);
+    else if (strcmp(mode, "document") == 0)
+      retval = JSON_ParseDocumentFile(doc, argv[1], NULL, JSON_DICT_MIN_SIZE, 64);
+    else if (strcmp(mode, "cursor") == 0)
+      retval = parse_cursor(argv[1], &sum);
+    else if (strcmp(mode, "tape") == 0)
+      retval = JSON_ParseTapeFile(tape, argv[1]);
+    else if (strcmp(mode, "events") == 0)
+      retval = parse_events(&type, argv[1], &sum);
+    else if (strcmp(mode, "records") == 0)
+      retval = parse_records(doc, argv[1], &sum);
+    else if (strcmp(mode, "array") == 0)
+      retval = parse_array(&type, argv[1]);
+    else if (strcmp(mode, "parallel") == 0)
+      retval = parse_records(NULL, argv[1], &sum);
+    else if (strcmp(mode, "build") == 0)
+      retval = parse_events(&type, argv[1], NULL);
+    else if (buf)
+      retval = JSON_ParseDocumentInSitu(doc, buf, size, NULL, JSON_DICT_MIN_SIZE, 64);
+    else
+      retval = JSON_parse(&type, in, NULL, JSON_DICT_MIN_SIZE, 64);
+
+    if (retval != 0)
+    {
+      fclose(in);
+      return 1;
+    }
+
+    if (type)
+      JSON_FreeType(type);
+    else
+    {
+      JSON_ResetDocument(doc);
+      JSON_ResetTape(tape);
+    }
+
+    double elapsed = now() - start;
+
+    if (best == 0 || elapsed < best)
+      best = elapsed;
+
+    free(buf);
+    fclose(in);
+  }
+
+  JSON_FreeDocument(doc);
+  JSON_FreeTape(tape);
+
+  printf("%s (%s, %s): %ld bytes, best of %d: %.3f s, %.1f MB/s\n",
+         argv[1], mode,
+         JSON_GetParserEngine() == JSON_PARSER_DESCENT ? "descent" : "bison",
+         size, rounds, best,
+         size / best / 1e6);
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file allocator.h
+ *
+ * @brief Interface to JSON_Allocator structure.
+ *
+ * Every allocation made by the constructors, the lexer and the parser
+ * goes through a JSON_Allocator. The default one calls the C
+ * library. Others, @e e.g a JSON_Arena or a counting allocator, are
+ * plugged by passing them to the @b With variants of the
+ * constructors and to JSON_ParseReaderWith().
+ */
+
+#ifndef _JSON_ALLOCATOR_H
+#define _JSON_ALLOCATOR_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Allocator
+ *
+ * @brief A table of allocation functions and their context.
+ *
+ * Every function receives @b ctx as its first argument. The memory
+ * returned by @b alloc is not initialized.
+ */
+typedef struct JSON_Allocator
+{
+  void* (*alloc)   (void* ctx, size_t size);            /**< Like malloc. */
+  void* (*realloc) (void* ctx, void* ptr, size_t old,
+                    size_t size);                       /**< Like realloc;
+                                                         * @b old is the
+                                                         * current size. */
+  void  (*free)    (void* ctx, void* ptr);              /**< Like free. */
+
+  void* ctx; /**< The user context. */
+} JSON_Allocator;
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+/** The allocator of the C library, used when none is given. */
+extern const JSON_Allocator JSON_DefaultAllocator;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Allocate zeroed memory from a JSON_Allocator.
+ *
+ * @param [in] alloc The JSON_Allocator to use.
+ *
+ * @param [in] size The number of bytes to allocate.
+ *
+ * @return A pointer to the memory or @b NULL on failure.
+ */
+void* JSON_AllocZero(const JSON_Allocator* alloc, size_t size);
+
+
+
+
+/**
+ * @brief Copy a string with a JSON_Allocator.
+ *
+ * @param [in] alloc The JSON_Allocator to use.
+ *
+ * @param [in] str The string to copy.
+ *
+ * @return A pointer to the copy or @b NULL on failure.
+ */
+char* JSON_AllocString(const JSON_Allocator* alloc, const char* str);
+#endif // _JSON_ALLOCATOR_H
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file arena.h
+ *
+ * @brief Interfaces to JSON_Arena structure.
+ *
+ * A JSON_Arena is a bump allocator. Memory is taken from large chunks
+ * by moving a cursor, and is never freed one allocation at a
+ * time. Instead, the whole arena is reset at once.
+ *
+ * An arena is plugged in the constructors and the parser through a
+ * JSON_Allocator; see JSON_InitArenaAllocator().
+ */
+
+#ifndef _JSON_ARENA_H
+#define _JSON_ARENA_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+#include "allocator.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** Default size of the first chunk, in bytes. */
+#define JSON_ARENA_CHUNK (1 << 16)
+
+/** Chunks double in size up to that many bytes. */
+#define JSON_ARENA_MAX_CHUNK (1 << 24)
+
+/** Alignment of every allocation, in bytes. */
+#define JSON_ARENA_ALIGN 8
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Chunk
+ *
+ * @brief A block of memory owned by a JSON_Arena.
+ */
+typedef struct JSON_Chunk
+{
+  struct JSON_Chunk* next; /**< The next chunk of the arena. */
+  size_t             size; /**< The number of bytes in data. */
+  char               data[]; /**< The memory given away. */
+} JSON_Chunk;
+
+
+
+
+/**
+ * @struct JSON_Arena
+ *
+ * @brief A structure that allocate memory from a list of chunks.
+ *
+ * Allocations are taken from [@b cursor, @b limit) in the current
+ * chunk. When it's full, the next chunk is used, or a new one twice as
+ * large is allocated. A reset only rewinds to the first chunk; chunks
+ * are kept and reused by the next allocations.
+ */
+typedef struct JSON_Arena
+{
+  JSON_Chunk* first;   /**< The first chunk, or @b NULL. */
+  JSON_Chunk* current; /**< The chunk being filled. */
+
+  char* cursor; /**< The next free byte in the current chunk. */
+  char* limit;  /**< One past the last byte of the current chunk. */
+  char* last;   /**< The last allocation, that can grow in place. */
+
+  size_t chunk; /**< The size of the next chunk to allocate. */
+  size_t count; /**< The number of chunks. */
+} JSON_Arena;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Allocate memory for a JSON_Arena.
+ *
+ * @param [in] chunk The size of the first chunk, or 0 for
+ * JSON_ARENA_CHUNK.
+ *
+ * @return A pointer to the allocated JSON_Arena or @b NULL on
+ * failure.
+ *
+ * @note No chunk is allocated until the first allocation.
+ */
+JSON_Arena* JSON_MallocArena(size_t chunk);
+
+
+
+
+/**
+ * @brief Procedure that free from memory a JSON_Arena and every
+ * allocation made from it.
+ *
+ * @param [in,out] arena The JSON_Arena to free from memory.
+ */
+void JSON_FreeArena(JSON_Arena* arena);
+
+
+
+
+/**
+ * @brief Release every allocation made from a JSON_Arena.
+ *
+ * @param [in,out] arena The JSON_Arena to reset.
+ *
+ * @note The chunks are kept for the next allocations.
+ */
+void JSON_ResetArena(JSON_Arena* arena);
+
+
+
+
+/**
+ * @brief Allocate memory from a JSON_Arena.
+ *
+ * @param [in,out] arena The JSON_Arena to allocate from.
+ *
+ * @param [in] size The number of bytes to allocate.
+ *
+ * @return A pointer aligned on JSON_ARENA_ALIGN bytes, or @b NULL on
+ * failure. The memory is not initialized.
+ */
+void* JSON_ArenaAlloc(JSON_Arena* arena, size_t size);
+
+
+
+
+/**
+ * @brief Allocate zeroed memory from a JSON_Arena.
+ *
+ * @param [in,out] arena The JSON_Arena to allocate from.
+ *
+ * @param [in] n The number of elements.
+ *
+ * @param [in] size The size of an element.
+ *
+ * @return Same as JSON_ArenaAlloc().
+ */
+void* JSON_ArenaCalloc(JSON_Arena* arena, size_t n, size_t size);
+
+
+
+
+/**
+ * @brief Change the size of an allocation made from a JSON_Arena.
+ *
+ * @param [in,out] arena The JSON_Arena to allocate from.
+ *
+ * @param [in] ptr The allocation, or @b NULL.
+ *
+ * @param [in] old The current size of the allocation.
+ *
+ * @param [in] size The new size.
+ *
+ * @return A pointer to the allocation, or @b NULL on failure; @b ptr
+ * is left untouched.
+ *
+ * @note The last allocation grows in place if the chunk has room.
+ * Otherwise, it's copied and the old bytes are lost until the next
+ * reset.
+ */
+void* JSON_ArenaRealloc(JSON_Arena* arena, void* ptr, size_t old, size_t size);
+
+
+
+
+/**
+ * @brief Give back an allocation made from a JSON_Arena.
+ *
+ * @param [in,out] arena The JSON_Arena the allocation was made from.
+ *
+ * @param [in] ptr The allocation, or @b NULL.
+ *
+ * @note Only the last allocation is given back, and reused by the
+ * next one. Others are lost until the next reset.
+ */
+void JSON_ArenaFree(JSON_Arena* arena, void* ptr);
+
+
+
+
+/**
+ * @brief Initialize a JSON_Allocator that allocate from a JSON_Arena.
+ *
+ * @param [out] alloc The JSON_Allocator to initialize.
+ *
+ * @param [in] arena The JSON_Arena to allocate from. It must outlive
+ * the allocator.
+ *
+ * @note Freeing memory with such allocator calls JSON_ArenaFree();
+ * the rest is released by JSON_ResetArena().
+ */
+void JSON_InitArenaAllocator(JSON_Allocator* alloc, JSON_Arena* arena);
+#endif // _JSON_ARENA_H
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cursor.h
+ *
+ * @brief Interfaces to JSON_Cursor structure.
+ *
+ * A JSON_Cursor points to a value in a buffer, without parsing it.
+ * Navigating to a label or an index only reads the labels on the way;
+ * the values passed over are skipped by matching their brackets, and
+ * are never built nor validated. Only the values actually read are
+ * decoded, by the lexer of the parser.
+ *
+ * A cursor is a plain structure: copy it to keep a position. It's
+ * valid as long as its buffer.
+ */
+
+#ifndef _JSON_CURSOR_H
+#define _JSON_CURSOR_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+#include "json.h"
+#include "number.h"
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Cursor
+ *
+ * @brief A structure that point to a value in a buffer.
+ */
+typedef struct JSON_Cursor
+{
+  const char* at;    /**< The first character of the value, or @b NULL
+                      * before the first element of a container. */
+  const char* end;   /**< One past the last character of the buffer. */
+  const char* label; /**< The opening quote of the label of the value,
+                      * if in a dict. */
+} JSON_Cursor;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Point a JSON_Cursor to the value of a buffer.
+ *
+ * @param [out] cursor The JSON_Cursor to initialize.
+ *
+ * @param [in] buf The buffer. It must outlive the cursor.
+ *
+ * @param [in] len The length of the buffer.
+ *
+ * @return 0 on success, -1 if the buffer is blank.
+ */
+int JSON_OpenCursor(JSON_Cursor* cursor, const char* buf, size_t len);
+
+
+
+
+/**
+ * @brief Get the type of the value of a JSON_Cursor, from its first
+ * character.
+ *
+ * @return The JSON_Types of the value, JSON_NUMBER for every number
+ * and JSON_NONE if it's invalid.
+ */
+JSON_Types JSON_CursorType(const JSON_Cursor* cursor);
+
+
+
+
+/**
+ * @brief Move to the next element of a dict or a list.
+ *
+ * @param [in] container The JSON_Cursor of the dict or the list.
+ *
+ * @param [in,out] element The JSON_Cursor of the previous element,
+ * with @b at set to @b NULL to start from the first one.
+ *
+ * @return 0 if @b element points to the next element, -1 past the
+ * last one or if the container is invalid.
+ */
+int JSON_CursorNext(const JSON_Cursor* container, JSON_Cursor* element);
+
+
+
+
+/**
+ * @brief Look a label up in a dict.
+ *
+ * @param [in] dict The JSON_Cursor of the dict.
+ *
+ * @param [in] label The label to look for.
+ *
+ * @param [out] value The JSON_Cursor of the first value with that
+ * label.
+ *
+ * @return 0 on success, -1 if there's no such label.
+ */
+int JSON_CursorGet(const JSON_Cursor* dict, const char* label, JSON_Cursor* value);
+
+
+
+
+/**
+ * @brief Get an element of a list.
+ *
+ * @param [in] list The JSON_Cursor of the list.
+ *
+ * @param [in] n The position of the element.
+ *
+ * @param [out] value The JSON_Cursor of the element.
+ *
+ * @return 0 on success, -1 if @b n is out of range.
+ */
+int JSON_CursorAt(const JSON_Cursor* list, size_t n, JSON_Cursor* value);
+
+
+
+
+/**
+ * @brief Decode the label of the value of a JSON_Cursor.
+ *
+ * @return The label, to release with free(), or @b NULL if the value
+ * isn't in a dict.
+ */
+char* JSON_CursorLabel(const JSON_Cursor* cursor);
+
+
+
+
+/**
+ * @brief Decode the string of a JSON_Cursor.
+ *
+ * @return The string, to release with free(), or @b NULL if the value
+ * isn't a valid string.
+ */
+char* JSON_CursorString(const JSON_Cursor* cursor);
+
+
+
+
+/**
+ * @brief Decode the number of a JSON_Cursor.
+ *
+ * @param [in] cursor The JSON_Cursor of the number.
+ *
+ * @param [out] number The number, with its exact type.
+ *
+ * @return 0 on success, -1 if the value isn't a valid number.
+ */
+int JSON_CursorNumber(const JSON_Cursor* cursor, JSON_Number* number);
+
+
+
+
+/**
+ * @brief Decode the boolean of a JSON_Cursor.
+ *
+ * @param [in] cursor The JSON_Cursor of the boolean.
+ *
+ * @param [out] value -1 for false, 1 for true and 0 for null.
+ *
+ * @return 0 on success, -1 if the value isn't a boolean.
+ */
+int JSON_CursorBool(const JSON_Cursor* cursor, int* value);
+
+
+
+
+/**
+ * @brief Parse the value of a JSON_Cursor into a JSON_Type.
+ *
+ * @param [in] cursor The JSON_Cursor of the value.
+ *
+ * @return The value, to release with JSON_FreeType(), or @b NULL if
+ * it's invalid.
+ *
+ * @note Dicts and lists are parsed with JSON_ParseBuffer(), with the
+ * default hash function.
+ */
+JSON_Type* JSON_CursorValue(const JSON_Cursor* cursor);
+#endif // _JSON_CURSOR_H
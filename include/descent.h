@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file descent.h
+ *
+ * @brief Interfaces to the hand-written parser and to the choice of the
+ * parser engine.
+ *
+ * The hand-written parser accepts the same grammar as the Bison parser,
+ * from the same lexer, and builds the same JSON_Type trees. It keeps an
+ * explicit stack of the open containers instead of recursing, and
+ * attaches every value to its container as soon as it's read, without
+ * the semantic values and the stacks of the Bison parser.
+ */
+
+#ifndef _JSON_DESCENT_H
+#define _JSON_DESCENT_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+#include "parser.h"
+
+
+
+
+/*=============================================================================+
+ |                                    Enums                                    |
+ +=============================================================================*/
+/**
+ * @enum JSON_ParserEngine
+ *
+ * @brief Enumerate the engines of the parser.
+ */
+typedef enum JSON_ParserEngine
+{
+  JSON_PARSER_BISON,  /**< The LALR parser generated by Bison */
+  JSON_PARSER_DESCENT /**< The hand-written parser */
+} JSON_ParserEngine;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Set the engine of the parse functions, @e e.g.
+ * JSON_ParseReader() and JSON_ParseDocument().
+ *
+ * @param [in] engine The JSON_ParserEngine to use. JSON_PARSER_BISON by
+ * default, or JSON_PARSER_DESCENT if configured with
+ * --enable-descent.
+ *
+ * @note JSON_PushParser always uses the Bison parser.
+ */
+void JSON_SetParserEngine(JSON_ParserEngine engine);
+
+
+
+
+/**
+ * @brief Get the engine of the parse functions.
+ */
+JSON_ParserEngine JSON_GetParserEngine(void);
+
+
+
+
+/**
+ * @brief Parse a reader with the hand-written parser.
+ *
+ * @param [out] type The value parsed, to release with
+ * JSON_FreeTypeWith(), untouched if the input is empty and @b NULL on
+ * failure.
+ *
+ * @param [in,out] reader The JSON_Reader to parse.
+ *
+ * @param [in] hashFunc, dictSize, listSize Same as JSON_ParseReader().
+ *
+ * @param [in] alloc The JSON_Allocator of the tree.
+ *
+ * @param [in,out] keys The JSON_InternTable of the labels, or @b NULL
+ * to copy every label.
+ *
+ * @return 0 on success, 1 if the input is invalid and 2 on memory
+ * exhaustion.
+ */
+int JSON_DescentParse(struct JSON_Type**    type,
+                      JSON_Reader*          reader,
+                      JSON_Hash             hashFunc,
+                      size_t                dictSize,
+                      size_t                listSize,
+                      const JSON_Allocator* alloc,
+                      JSON_InternTable*     keys);
+
+
+
+
+/**
+ * @brief Parse a reader with the engine set by JSON_SetParserEngine().
+ *
+ * Either engine fails the same way: nothing is left to release, and
+ * @b type is @b NULL.
+ *
+ * @return Same as JSON_DescentParse().
+ */
+int JSON_EngineParse(struct JSON_Type**    type,
+                     JSON_Reader*          reader,
+                     JSON_Hash             hashFunc,
+                     size_t                dictSize,
+                     size_t                listSize,
+                     const JSON_Allocator* alloc,
+                     JSON_InternTable*     keys);
+#endif // _JSON_DESCENT_H
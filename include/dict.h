@@ -27,6 +27,7 @@
 /*=============================================================================+
  |                                  Includes                                   |
  +=============================================================================*/
+#include <stdint.h>
 #include <stdlib.h>
 
 
@@ -35,8 +36,9 @@
 /*=============================================================================+
  |                                  Typedefs                                   |
  +=============================================================================*/
-typedef struct JSON_Type JSON_Type;
-typedef struct JSON_List JSON_List;
+typedef struct JSON_Allocator JSON_Allocator;
+typedef struct JSON_Type      JSON_Type;
+typedef struct JSON_List      JSON_List;
 
 /** This typedef might change in the futur. It's use by JSON_Dict as
  *  the type to hash for its hash function. */
@@ -49,6 +51,35 @@ typedef size_t (*JSON_HashFunc) (JSON_HashKey);
 
 
 
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The smallest number of buckets of a JSON_Dict. */
+#define JSON_DICT_MIN_SIZE 8
+
+/** The largest number of entries of a JSON_Dict kept in a flat array. */
+#define JSON_DICT_FLAT_MAX 8
+
+
+
+
+/*=============================================================================+
+ |                                    Enums                                    |
+ +=============================================================================*/
+/**
+ * @enum JSON_DictEngine
+ *
+ * @brief Enumerate the hash table layouts of a JSON_Dict.
+ */
+typedef enum JSON_DictEngine
+{
+  JSON_DICT_CHAINED, /**< Buckets of chains of entries */
+  JSON_DICT_OPEN     /**< Open addressing with SIMD probed control bytes */
+} JSON_DictEngine;
+
+
+
+
 /*=============================================================================+
  |                                 Structures                                  |
  +=============================================================================*/
@@ -57,23 +88,30 @@ typedef size_t (*JSON_HashFunc) (JSON_HashKey);
  *
  * @brief A structure that hold a hash table of JSON_Type.
  *
- * The structure has 3 members:
- * - A pointer to a JSON_HashFunc function, called @b hash that
- * will be called when you try to access an element from the dict.
- *
- * - A positive number, called @b size, that represent the number of
- * buckets in the dict.
+ * The entries are kept in @b entries, in insertion order. Setting a
+ * new value for a key keeps the position of the old one. Removing an
+ * entry leaves a @b NULL hole, squeezed out the next time the array is
+ * full. Iterating, printing or freeing a dict only walks that array.
  *
- * - A pointer to pointers of JSON_Type, @b buckets is a list of
- * JSON_Type. Every entries in the list act as a linked list.
- *
- * A JSON_Dict has a fixed size of buckets. Every bucket entry is a
- * the head of a linked list of JSON_Type. It uses its hash function
- * in order to retrieve the associated bucket. This is why it's
+ * The hash table is an index of positions in @b entries. It uses the
+ * hash function of the dict in order to find a key. This is why it's
  * important to NOT modify the hash function after the initialization
  * of the structure.
  *
+ * - With the JSON_DICT_CHAINED engine, @b index has one position per
+ * bucket, the first entry of a chain, and @b links the next position
+ * of each entry in its chain. The number of buckets doubles whenever
+ * the dict is more than 3/4 full.
+ *
+ * - With the JSON_DICT_OPEN engine, @b index has one position per
+ * slot, and @b ctrl has one control byte per slot: empty, deleted or
+ * 7 bits of the hash of the entry. A lookup compares 16 control bytes
+ * at once and only reads the labels whose bits match. The table is
+ * rebuilt when it's 7/8 full.
  *
+ * Small dicts have no index at all: while @b flat is set, a lookup
+ * compares the hash of each entry. The index is built past
+ * JSON_DICT_FLAT_MAX entries.
  */
 typedef struct JSON_Dict
 {
@@ -82,12 +120,31 @@ typedef struct JSON_Dict
                        * never be modify directly. Only access it in
                        * order to call it as a regular function.*/
 
-  size_t size; /**< The number of buckets in the hash table.*/
+  JSON_DictEngine engine; /**< The layout of the index.*/
+  int             flat;   /**< Non zero while there's no index.*/
+
+  struct JSON_Type** entries; /**< The entries in insertion order,
+                               * with @b NULL holes.*/
+
+  size_t   used;     /**< The number of entries used, holes included.*/
+  size_t   capacity; /**< The number of entries allocated.*/
+  size_t   count;    /**< The number of entries in the hash table.*/
+  size_t   size;     /**< The number of buckets or slots of the index.*/
+  size_t   growth;   /**< The number of empty slots that can be used
+                      * before a rebuild, if open.*/
+  unsigned shift;    /**< Shift of the mixed hash that gives the bucket,
+                      * or the group of slots if open.*/
+
+  uint32_t* index; /**< The position of an entry per bucket or slot,
+                    * @b NULL if flat.*/
+  uint32_t* links; /**< The next position in the chain of each entry,
+                    * if chained.*/
 
-  struct JSON_Type** buckets; /**< The actual hash table implemented
-                               * as a fixed list. Every entries in the
-                               * list act as a linked list of
-                               * JSON_Type.*/
+  unsigned char* ctrl; /**< The control bytes of the slots if open,
+                        * @b NULL otherwise.*/
+
+  const struct JSON_Allocator* alloc; /**< The allocator of the dict
+                                       * and its entries.*/
 } JSON_Dict;
 
 
@@ -96,11 +153,26 @@ typedef struct JSON_Dict
 /*=============================================================================+
  |                             Function Prototypes                             |
  +=============================================================================*/
+/**
+ * @brief Set the engine of the dicts allocated without one, @e e.g by
+ * the parser.
+ *
+ * @param [in] engine The JSON_DictEngine to use. JSON_DICT_CHAINED by
+ * default.
+ */
+void JSON_SetDictEngine(JSON_DictEngine engine);
+
+
+
+
 /**
  * @brief Allocate memory for a JSON_Dict.
  *
- * @param [in] size The size of the dict.
- * @param [in] hash The hash function to use by the hash table.
+ * @param [in] size The expected number of entries. It's only a hint
+ * for the initial capacity; the dict grows as needed. Up to
+ * JSON_DICT_FLAT_MAX, the dict starts flat.
+ * @param [in] hash The hash function to use by the hash table, or
+ * @b NULL for JSON_DefaultHash().
  *
  * @return A pointer to the allocated JSON_Dict or @b NULL on
  * failure; more info by calling JSON_GetError().
@@ -110,6 +182,47 @@ JSON_Dict* JSON_MallocDict(size_t size, JSON_HashFunc hash);
 
 
 
+/**
+ * @brief Allocate memory for a JSON_Dict with a JSON_Allocator.
+ *
+ * @param [in] alloc The JSON_Allocator to use, or @b NULL for the
+ * default one. It must outlive the dict.
+ *
+ * @param [in] size The expected number of entries.
+ *
+ * @param [in] hash The hash function to use, or @b NULL for
+ * JSON_DefaultHash().
+ *
+ * @return Same as JSON_MallocDict().
+ */
+JSON_Dict* JSON_MallocDictWith(const JSON_Allocator* alloc, size_t size, JSON_HashFunc hash);
+
+
+
+
+/**
+ * @brief Allocate memory for a JSON_Dict with a given engine.
+ *
+ * @param [in] alloc The JSON_Allocator to use, or @b NULL for the
+ * default one.
+ *
+ * @param [in] size The expected number of entries.
+ *
+ * @param [in] hash The hash function to use, or @b NULL for
+ * JSON_DefaultHash().
+ *
+ * @param [in] engine The JSON_DictEngine to use.
+ *
+ * @return Same as JSON_MallocDict().
+ */
+JSON_Dict* JSON_MallocDictEngine(const JSON_Allocator* alloc,
+                                 size_t size,
+                                 JSON_HashFunc hash,
+                                 JSON_DictEngine engine);
+
+
+
+
 /**
  * @brief Procedure that free from memory a JSON_Dict.
  *
@@ -122,6 +235,23 @@ void JSON_FreeDict(JSON_Dict* dict);
 
 
 
+/**
+ * @brief Iterate over the entries of a JSON_Dict.
+ *
+ * @param [in] dict The JSON_Dict to iterate over.
+ *
+ * @param [in,out] i The position of the iteration, 0 to start.
+ *
+ * @return The next entry, or @b NULL at the end.
+ *
+ * @note The entries come in insertion order. The dict must not be
+ * modified during the iteration; the returned entry may be freed.
+ */
+JSON_Type* JSON_NextDictValue(const JSON_Dict* dict, size_t* i);
+
+
+
+
 /**
  * @brief Get the bucket of a dict associated with a key.
  *
@@ -144,7 +274,8 @@ const JSON_Type* JSON_GetDictValue(const JSON_HashKey key,
  * @param [in] value A pointer to the value to add.
  *
  * @return A pointer to the previous value that has been overwrite, if
- * any. @b NULL otherwise.
+ * any. @b NULL otherwise. If the table can't grow, @b value itself is
+ * returned and not inserted; see JSON_GetError().
  *
  * @warning It's the responsability of the user to free from memory,
  * or at least catch the returned pointer, in order to avoid memory
@@ -159,6 +290,23 @@ JSON_Type* JSON_SetDictValue(JSON_Dict* dict, JSON_Type* value);
 
 
 
+/**
+ * @brief Set a value whose label is already hashed in the hash table
+ * of a JSON_Dict.
+ *
+ * @param [in,out] dict The JSON_Dict to add the value to.
+ *
+ * @param [in] value A pointer to the value to add. Its @b hash and
+ * @b length must be those of its label, for the hash function of the
+ * dict; @e e.g set by JSON_InternString() for JSON_DefaultHash().
+ *
+ * @return Same as JSON_SetDictValue().
+ */
+JSON_Type* JSON_SetDictHashedValue(JSON_Dict* dict, JSON_Type* value);
+
+
+
+
 /**
  * @brief Remove and free from memory a JSON_Type in a JSON_Dict.
  *
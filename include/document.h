@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file document.h
+ *
+ * @brief Interfaces to JSON_Document structure.
+ *
+ * A JSON_Document owns a parsed tree. Every node, string and container
+ * of the tree is allocated from the JSON_Arena of the document, so
+ * parsing costs a few large allocations instead of a few per value, and
+ * the whole tree is released at once.
+ *
+ * The labels of the dicts of a document are interned: equal labels
+ * are the same string, allocated once. They must not be modified.
+ *
+ * A document parsed in situ by JSON_ParseDocumentInSitu() doesn't
+ * copy its strings: they point in the input, decoded in place.
+ *
+ * Documents are filled by JSON_ParseDocument() and friends; see
+ * parser.h.
+ */
+
+#ifndef _JSON_DOCUMENT_H
+#define _JSON_DOCUMENT_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include "arena.h"
+#include "intern.h"
+#include "json.h"
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Document
+ *
+ * @brief A structure that own a JSON tree and its memory.
+ */
+typedef struct JSON_Document
+{
+  JSON_Arena*    arena; /**< The arena every node is allocated from. */
+  JSON_Allocator alloc; /**< The allocator of the arena. */
+  JSON_Type*     root;  /**< The root of the tree, or @b NULL. */
+
+  JSON_InternTable* keys; /**< The labels of the tree. */
+} JSON_Document;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Allocate memory for an empty JSON_Document.
+ *
+ * @return A pointer to the allocated JSON_Document or @b NULL on
+ * failure.
+ */
+JSON_Document* JSON_MallocDocument(void);
+
+
+
+
+/**
+ * @brief Procedure that free from memory a JSON_Document and its tree.
+ *
+ * @param [in,out] document The JSON_Document to free from memory.
+ */
+void JSON_FreeDocument(JSON_Document* document);
+
+
+
+
+/**
+ * @brief Release the tree of a JSON_Document.
+ *
+ * @param [in,out] document The JSON_Document to reset.
+ *
+ * @note The memory of the arena is kept for the next parse. Every
+ * pointer in the old tree is invalidated.
+ */
+void JSON_ResetDocument(JSON_Document* document);
+#endif // _JSON_DOCUMENT_H
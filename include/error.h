@@ -19,6 +19,9 @@
  * @file error.h
  *
  * @brief Interface to JSON error system.
+ *
+ * The last error is per thread: an error raised by a thread is only
+ * seen by that thread.
  */
 
 #ifndef _JSON_ERROR_H
@@ -41,6 +44,7 @@ typedef enum JSON_Errors
   JSON_ELIST_SIZE_EQZ,       /**< List has vector of size 0 */
   JSON_ELIST_BAD_INDEX,      /**< List index is invalid */
   JSON_EUSER,                /**< Reserved error for user */
+  JSON_EDICT_FAILED_REHASH,  /**< Dict failed to grow its table */
   JSON_ETOTAL                /**< Number of errors */
 } JSON_Errors;
 
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file hash.h
+ *
+ * @brief Interface to the default hash function of JSON_Dict.
+ *
+ * The default hash is a wyhash-like function: 8 bytes are read at a
+ * time and mixed with 64 x 64 -> 128 bits multiplications. It's keyed
+ * by a random seed, drawn once per process, so the buckets of a dict
+ * can't be predicted by whoever wrote the JSON being parsed.
+ *
+ * A JSON_Dict created with a @b NULL hash function uses it, and calls
+ * it directly instead of through its JSON_HashFunc pointer.
+ */
+
+#ifndef _JSON_HASH_H
+#define _JSON_HASH_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dict.h"
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Hash bytes with the default hash function.
+ *
+ * @param [in] data The bytes to hash.
+ *
+ * @param [in] len The number of bytes.
+ *
+ * @return The hash, for the seed of the process.
+ */
+uint64_t JSON_HashBytes(const void* data, size_t len);
+
+
+
+
+/**
+ * @brief The default JSON_HashFunc.
+ *
+ * @param [in] key The key to hash.
+ *
+ * @return Same as JSON_HashBytes() on the characters of the key.
+ */
+size_t JSON_DefaultHash(JSON_HashKey key);
+
+
+
+
+/**
+ * @brief Set the seed of the default hash function.
+ *
+ * @param [in] seed The new seed.
+ *
+ * @note Only useful to get the same hashes in every run, e.g. for
+ * benchmarks. Dicts that already have entries must not be used
+ * afterward, since their entries were placed with the old seed.
+ */
+void JSON_SetHashSeed(uint64_t seed);
+#endif // _JSON_HASH_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file index.h
+ *
+ * @brief Interfaces to JSON_Index structure.
+ *
+ * A JSON_Index is built by an optional first pass over a buffer. It
+ * holds the offset of every token start, i.e the structural
+ * characters @b {}[]:, the opening quotes of strings and the first
+ * character of every other scalar. Characters inside strings are
+ * never part of the index.
+ *
+ * The buffer is classified 64 bytes at a time by a SIMD kernel
+ * selected at runtime (AVX2, SSE4.2 or a scalar fallback). Once
+ * attached to a JSON_Reader, the lexer jumps from one token to the
+ * next instead of checking every byte.
+ */
+
+#ifndef _JSON_INDEX_H
+#define _JSON_INDEX_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "reader.h"
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Index
+ *
+ * @brief A structure that hold the offsets of every token start in a
+ * buffer.
+ *
+ * Offsets are 32 bits, so a buffer can't be larger than 4 GiB.
+ */
+typedef struct JSON_Index
+{
+  uint32_t* positions; /**< The offsets of every token start, in order. */
+  size_t    count;     /**< The number of offsets. */
+  size_t    size;      /**< The capacity of positions. */
+} JSON_Index;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Allocate memory for a JSON_Index and index a buffer.
+ *
+ * @param [in] buf The buffer to index.
+ *
+ * @param [in] len The length of the buffer.
+ *
+ * @return A pointer to the allocated JSON_Index or @b NULL on
+ * failure, @e e.g if the buffer is larger than 4 GiB.
+ */
+JSON_Index* JSON_MallocIndex(const char* buf, size_t len);
+
+
+
+
+/**
+ * @brief Allocate memory for a JSON_Index and index a buffer with a
+ * given kernel.
+ *
+ * @param [in] buf The buffer to index.
+ *
+ * @param [in] len The length of the buffer.
+ *
+ * @param [in] name The name of the kernel, see JSON_GetIndexKernel(),
+ * or @b NULL for the best one.
+ *
+ * @return A pointer to the allocated JSON_Index or @b NULL on
+ * failure, @e e.g if the CPU doesn't support the kernel.
+ */
+JSON_Index* JSON_MallocIndexKernel(const char* buf, size_t len, const char* name);
+
+
+
+
+/**
+ * @brief Procedure that free from memory a JSON_Index.
+ *
+ * @param [in,out] index The JSON_Index to free from memory.
+ */
+void JSON_FreeIndex(JSON_Index* index);
+
+
+
+
+/**
+ * @brief Attach a JSON_Index to a JSON_Reader.
+ *
+ * @param [in,out] reader The in memory JSON_Reader. Its cursor must be
+ * at the start of the indexed buffer.
+ *
+ * @param [in] index The index of the buffer. It must outlive the
+ * reader.
+ *
+ * @return 0 on success, -1 if the reader reads from a stream.
+ *
+ * @note While the index is attached, locations reported by the parser
+ * are byte offsets in the buffer instead of lines and columns.
+ */
+int JSON_IndexReader(JSON_Reader* reader, const JSON_Index* index);
+
+
+
+
+/**
+ * @brief Get the name of the kernel used to index buffers.
+ *
+ * @return "avx2", "sse4.2" or "scalar".
+ */
+const char* JSON_GetIndexKernel(void);
+#endif // _JSON_INDEX_H
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file intern.h
+ *
+ * @brief Interfaces to JSON_InternTable structure.
+ *
+ * An intern table keeps one copy of every distinct string given to
+ * it, with its hash. A JSON_Document interns the labels of its dicts,
+ * so every dict of a same schema shares the same labels. Two labels
+ * of a document are equal if and only if they're the same pointer.
+ *
+ * The table doesn't own the strings. They must outlive it, or the
+ * table must be reset when they're released.
+ */
+
+#ifndef _JSON_INTERN_H
+#define _JSON_INTERN_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <stdlib.h>
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Key
+ *
+ * @brief A string, its length and its hash by JSON_HashBytes().
+ */
+typedef struct JSON_Key
+{
+  char*    str;    /**< The characters, NUL terminated. */
+  size_t   length; /**< The number of characters. */
+  uint64_t hash;   /**< The hash of the characters. */
+} JSON_Key;
+
+
+
+
+/**
+ * @struct JSON_InternTable
+ *
+ * @brief A set of strings, with linear probing in a power of two
+ * slots at most half full.
+ */
+typedef struct JSON_InternTable
+{
+  JSON_Key* slots; /**< The strings, @b NULL in free slots. */
+  size_t    size;  /**< The number of slots. */
+  size_t    count; /**< The number of strings. */
+} JSON_InternTable;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Allocate memory for an empty JSON_InternTable.
+ *
+ * @return A pointer to the allocated JSON_InternTable or @b NULL on
+ * failure.
+ */
+JSON_InternTable* JSON_MallocInternTable(void);
+
+
+
+
+/**
+ * @brief Procedure that free from memory a JSON_InternTable.
+ *
+ * @param [in,out] table The JSON_InternTable to free from memory.
+ *
+ * @note The strings are not freed.
+ */
+void JSON_FreeInternTable(JSON_InternTable* table);
+
+
+
+
+/**
+ * @brief Forget every string of a JSON_InternTable.
+ *
+ * @param [in,out] table The JSON_InternTable to reset.
+ *
+ * @note The slots are kept for the next strings.
+ */
+void JSON_ResetInternTable(JSON_InternTable* table);
+
+
+
+
+/**
+ * @brief Intern a string.
+ *
+ * @param [in,out] table The JSON_InternTable to look into.
+ *
+ * @param [in,out] key The string and its length. Its hash is set, and
+ * its string is replaced by the interned one if there's already one.
+ * Otherwise, the string is added to the table as is.
+ *
+ * @return 1 if @b key now holds a string of the table that was already
+ * there, 0 otherwise.
+ *
+ * @note If the table can't grow, the string is not added, but its
+ * hash is still set.
+ */
+int JSON_InternString(JSON_InternTable* table, JSON_Key* key);
+#endif // _JSON_INTERN_H
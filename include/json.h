@@ -42,6 +42,13 @@
  * smart structure, i.e it will grow automatically by itself when it's
  * full. However, it will not shrink. To do so, the user will have to
  * do it manually.
+ *
+ * The parse functions, @e e.g JSON_ParseReader() or JSON_ParseBuffer(),
+ * return 0 on success, 1 if the input is invalid and 2 on memory
+ * exhaustion. Those that open a path, JSON_ParseFile(),
+ * JSON_ParseDocumentFile() and JSON_ParseTapeFile(), return -1 if it
+ * can't be opened, and errno is set. An empty input is valid and
+ * gives no value.
  */
 
 #ifndef _JSON_H
@@ -50,6 +57,7 @@
  |                                  Includes                                   |
  +=============================================================================*/
 #include "dict.h"
+#include "hash.h"
 #include "list.h"
 #include "type.h"
 #endif // _JSON_H
@@ -39,6 +39,7 @@
 /*=============================================================================+
  |                            Forward Declarations                             |
  +=============================================================================*/
+struct JSON_Allocator;
 struct JSON_Type;
 
 
@@ -68,12 +69,16 @@ struct JSON_Type;
  * equal to the size, the size is double to fit more items and realloc
  * is called on the elements member. It's the user responsability to
  * avoid size_t overflow.
+ *
+ * The list and its vector are allocated, grown and freed with the
+ * JSON_Allocator given at its creation.
  */
 typedef struct JSON_List
 {
   struct JSON_Type** elements; /**< A list of pointer of JSON_Type. */
   size_t             size;     /**< The current size of the vector */
   size_t             index;    /**< The current index of the vector */
+  const struct JSON_Allocator* alloc; /**< The allocator of the list. */
 } JSON_List;
 
 
@@ -95,6 +100,21 @@ JSON_List* JSON_MallocList(size_t size);
 
 
 
+/**
+ * @brief Allocate memory for a JSON_List with a JSON_Allocator.
+ *
+ * @param [in] alloc The JSON_Allocator to use, or @b NULL for the
+ * default one. It must outlive the list.
+ *
+ * @param [in] size The size of the list.
+ *
+ * @return Same as JSON_MallocList().
+ */
+JSON_List* JSON_MallocListWith(const struct JSON_Allocator* alloc, size_t size);
+
+
+
+
 /**
  * @brief Procedure that free from memory a JSON_List.
  *
@@ -135,6 +155,23 @@ int JSON_PushList(struct JSON_Type* value, JSON_List* list);
 
 
 
+/**
+ * @brief Move every element of a list at the end of another, with at
+ * most one resize and one copy.
+ *
+ * @param [out] list The JSON_List to append to.
+ *
+ * @param [in,out] other The JSON_List to take the elements from. It's
+ * left empty. Both lists must share the same allocator.
+ *
+ * @return 0 on success, -1 on failure and @b other is left untouched;
+ * more info by calling JSON_GetError().
+ */
+int JSON_AppendList(JSON_List* list, JSON_List* other);
+
+
+
+
 /**
  * @brief Return the last element in a list. Remove it also from the
  * vector.
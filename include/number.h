@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file number.h
+ *
+ * @brief Interface to the JSON number parser.
+ *
+ * Numbers are parsed without the stdio layer nor the locale. The
+ * grammar of JSON numbers is strictly validated:
+ *
+ *     -? (0 | [1-9][0-9]*) (. [0-9]+)? ([eE] [+-]? [0-9]+)?
+ *
+ * The result is always correctly rounded. Small numbers are exact in
+ * double precision and take a fast path. Others go through the
+ * Eisel-Lemire algorithm, and numbers with more than 19 significant
+ * digits fall back to strtod in the C locale.
+ *
+ * A number without fraction nor exponent that fits in 64 bits is an
+ * integer, and is never converted to a double.
+ */
+
+#ifndef _JSON_NUMBER_H
+#define _JSON_NUMBER_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include "type.h"
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Number
+ *
+ * @brief A structure that hold a parsed number.
+ */
+typedef struct JSON_Number
+{
+  JSON_Types type; /**< JSON_INTEGER, JSON_UNSIGNED or JSON_NUMBER. */
+
+  union
+  {
+    int64_t  integer;
+    uint64_t uinteger;
+    double   num;
+  }; /**< Annonymous union, the member is given by the type. */
+} JSON_Number;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Parse a JSON number.
+ *
+ * @param [in] p The start of the number.
+ *
+ * @param [in] end One past the last character available.
+ *
+ * @param [out] x The parsed number. An integer if there's no fraction
+ * nor exponent and it fits in an int64_t, or an uint64_t if positive.
+ * Otherwise, a double.
+ *
+ * @return The number of characters parsed, or -1 if the characters
+ * at @b p are not a valid JSON number.
+ */
+ssize_t JSON_ParseNumber(const char* p, const char* end, JSON_Number* x);
+#endif // _JSON_NUMBER_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file parallel.h
+ *
+ * @brief Interfaces to the parallel parser of large lists.
+ *
+ * A list at the top level is cut in chunks of whole elements: the
+ * elements are walked by a JSON_Cursor, which only matches brackets.
+ * Every chunk is parsed as a list of its own on a pool of threads, and
+ * the lists are appended, in order, to the first one.
+ */
+
+#ifndef _JSON_PARALLEL_H
+#define _JSON_PARALLEL_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+#include "parser.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The smallest chunk given to a thread, in bytes. */
+#define JSON_PARALLEL_MIN_CHUNK (1 << 16)
+
+/** The largest chunk given to a thread, in bytes; a chunk is copied. */
+#define JSON_PARALLEL_MAX_CHUNK (1 << 24)
+
+/** The number of chunks per thread, to balance their load. */
+#define JSON_PARALLEL_SPLIT 8
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Parse a reader whose value is a list on a pool of threads.
+ *
+ * @param [out] type The value parsed, to release with JSON_FreeType().
+ *
+ * @param [in,out] reader The JSON_Reader to parse, consumed to its
+ * end.
+ *
+ * @param [in] threads The number of threads, or 0 for one per online
+ * processor.
+ *
+ * @param [in] hashFunc, dictSize, listSize Same as JSON_ParseReader().
+ *
+ * @return Same as JSON_ParseReader(). On failure, @b type is @b NULL.
+ *
+ * @note Anything but a list at the top level, a small input, a single
+ * thread or a reader that can't be read in place, @e e.g. a pipe, is
+ * parsed by the calling thread with JSON_ParseReader(). The locations
+ * of syntax errors are relative to the chunk.
+ */
+int JSON_ParseArrayParallel(struct JSON_Type** type,
+                            JSON_Reader*       reader,
+                            size_t             threads,
+                            JSON_Hash          hashFunc,
+                            size_t             dictSize,
+                            size_t             listSize);
+#endif // _JSON_PARALLEL_H
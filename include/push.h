@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file push.h
+ *
+ * @brief Interfaces to JSON_PushParser structure.
+ *
+ * A JSON_PushParser is fed the input in chunks, as it arrives, instead
+ * of reading it. Every complete token of a chunk is lexed and pushed
+ * to the Bison parser right away; only a token cut by the end of the
+ * chunk is kept, until the next one. A document is complete as soon
+ * as its outermost dict or list is closed, so the input after it, if
+ * any, is the start of the next document.
+ *
+ * A parser holds no thread nor blocking call: one thread can feed the
+ * parsers of many connections.
+ */
+
+#ifndef _JSON_PUSH_H
+#define _JSON_PUSH_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+#include "parser.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** Returned while a document is not complete. */
+#define JSON_PUSH_MORE -1
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_PushParser
+ *
+ * @brief A structure that parse an input pushed in chunks.
+ */
+typedef struct JSON_PushParser
+{
+  JSON_yypstate* state; /**< The state of the Bison parser. */
+  JSON_YYLTYPE   loc;   /**< The location in the document. */
+  JSON_Type*     root;  /**< The document, set when it's complete. */
+  size_t         depth; /**< The number of open dicts and lists. */
+
+  char*  pending; /**< The input not lexed yet: a cut token, or the
+                   * input after the last document. */
+  size_t used;    /**< The length of pending. */
+  size_t size;    /**< The capacity of pending. */
+  int    string;  /**< Non zero if the cut token is a string. */
+  int    escaped; /**< Non zero if the cut string ends with a
+                   * backslash that escapes the next character. */
+
+  JSON_Hash hashFunc;
+  size_t    dictSize;
+  size_t    listSize;
+} JSON_PushParser;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Allocate memory for a JSON_PushParser.
+ *
+ * @param [in] hashFunc, dictSize, listSize Same as JSON_ParseReader(),
+ * for every document.
+ *
+ * @return A pointer to the allocated JSON_PushParser or @b NULL on
+ * failure.
+ */
+JSON_PushParser* JSON_MallocPushParser(JSON_Hash hashFunc,
+                                       size_t    dictSize,
+                                       size_t    listSize);
+
+
+
+
+/**
+ * @brief Procedure that free from memory a JSON_PushParser.
+ *
+ * @param [in,out] parser The JSON_PushParser to free from memory. The
+ * document being parsed, if any, is released.
+ */
+void JSON_FreePushParser(JSON_PushParser* parser);
+
+
+
+
+/**
+ * @brief Drop the document being parsed and the pending input, to
+ * start again.
+ *
+ * @param [in,out] parser The JSON_PushParser to reset.
+ */
+void JSON_ResetPushParser(JSON_PushParser* parser);
+
+
+
+
+/**
+ * @brief Push a chunk of input to a JSON_PushParser.
+ *
+ * @param [in,out] parser The JSON_PushParser.
+ *
+ * @param [in] buf The chunk. It's not kept after the call.
+ *
+ * @param [in] len The length of the chunk, which can be 0 to parse the
+ * pending input.
+ *
+ * @param [out] type The document, to release with JSON_FreeType(), if
+ * it's complete.
+ *
+ * @return JSON_PUSH_MORE if the document isn't complete, 0 if it is,
+ * 1 if the input is invalid and 2 on memory exhaustion. On failure,
+ * the parser is reset.
+ *
+ * @note When a document is complete, the rest of the chunk is kept;
+ * push an empty chunk to parse it before the next one.
+ */
+int JSON_PushParse(JSON_PushParser* parser, const char* buf, size_t len,
+                   JSON_Type** type);
+
+
+
+
+/**
+ * @brief Tell a JSON_PushParser that the input ended.
+ *
+ * @param [in,out] parser The JSON_PushParser.
+ *
+ * @param [out] type The last document, or @b NULL if there's none.
+ *
+ * @return 0 on success, 1 if the last document is cut or invalid and
+ * 2 on memory exhaustion.
+ */
+int JSON_PushEnd(JSON_PushParser* parser, JSON_Type** type);
+#endif // _JSON_PUSH_H
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file reader.h
+ *
+ * @brief Interfaces to JSON_Reader structure.
+ *
+ * A JSON_Reader is the input layer of the lexer. Instead of pulling
+ * every byte through the stdio layer, the reader fills large aligned
+ * blocks from its stream and let the lexer scan them with pointer
+ * arithmetic.
+ */
+
+#ifndef _JSON_READER_H
+#define _JSON_READER_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** Number of bytes requested from the stream on every refill. */
+#define JSON_READER_BLOCK (1 << 18)
+
+/** Alignment of the reader block, in bytes. */
+#define JSON_READER_ALIGN 64
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Reader
+ *
+ * @brief A structure that buffer a stream by blocks.
+ *
+ * The bytes in [@b cursor, @b limit) are available to the lexer. When
+ * the cursor reach the limit, JSON_FillReader() is called to get the
+ * next block.
+ *
+ * A token can span two blocks. For that reason, the lexer set the
+ * @b mark member at the start of the token it's reading. On refill,
+ * every byte from the mark to the limit is kept at the start of the
+ * block, so the token is always contiguous in memory. If the token
+ * is larger than the block, the block grows.
+ *
+ * A reader without stream reads in place from a buffer in memory; see
+ * JSON_InitReader(). In that case, there's no block and nothing is
+ * copied. A file can also be mapped in memory with JSON_OpenReader().
+ *
+ * An in situ reader also lets the lexer write in its buffer: strings
+ * are decoded in place and NUL terminated over their closing quote,
+ * so they're never copied. See JSON_InitReaderInSitu().
+ */
+typedef struct JSON_Reader
+{
+  const char* cursor; /**< The next byte to read. */
+  const char* limit;  /**< One past the last valid byte. */
+  const char* mark;   /**< Start of the token being read, or @b NULL. */
+
+  char*  block; /**< The aligned buffer filled from the stream, or the
+                 * file mapping. */
+  size_t size;  /**< The capacity of the block. */
+  int    owner; /**< Non zero if the stream or the mapping was opened
+                 * by the reader itself. */
+  int    insitu; /**< Non zero if strings are decoded in the buffer. */
+
+  FILE* fd; /**< The stream to read from, or @b NULL if in memory. */
+
+  const char*     base; /**< Start of the indexed buffer. */
+  const uint32_t* next; /**< Next token start in the JSON_Index, or @b
+                         * NULL if there's no index. */
+  const uint32_t* last; /**< One past the last token start. */
+} JSON_Reader;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Allocate memory for a JSON_Reader.
+ *
+ * @param [in] fd The stream to read from.
+ *
+ * @return A pointer to the allocated JSON_Reader or @b NULL on
+ * failure.
+ *
+ * @note Nothing is read from the stream until the first call to
+ * JSON_FillReader().
+ */
+JSON_Reader* JSON_MallocReader(FILE* fd);
+
+
+
+
+/**
+ * @brief Initialize a JSON_Reader that read in place from memory.
+ *
+ * @param [out] reader The JSON_Reader to initialize.
+ *
+ * @param [in] buf The buffer to read from.
+ *
+ * @param [in] len The length of the buffer.
+ *
+ * @note The buffer is never copied nor modified. It must outlive the
+ * reader. Such reader should not be passed to JSON_FreeReader().
+ */
+void JSON_InitReader(JSON_Reader* reader, const char* buf, size_t len);
+
+
+
+
+/**
+ * @brief Initialize a JSON_Reader that read in place from memory, and
+ * decode the strings in place.
+ *
+ * @param [out] reader The JSON_Reader to initialize.
+ *
+ * @param [in,out] buf The buffer to read from. It's modified.
+ *
+ * @param [in] len The length of the buffer.
+ *
+ * @note The strings parsed point in the buffer, and are not allocated.
+ * Such reader must only be parsed in a JSON_Document, which never
+ * frees strings one by one, and the buffer must outlive the document.
+ */
+void JSON_InitReaderInSitu(JSON_Reader* reader, char* buf, size_t len);
+
+
+
+
+/**
+ * @brief Initialize a JSON_Reader that read from a file.
+ *
+ * @param [out] reader The JSON_Reader to initialize.
+ *
+ * @param [in] path The path of the file to read.
+ *
+ * @return 0 on success, -1 on failure and errno is set.
+ *
+ * @note A regular file is mapped read-only in memory and the kernel
+ * is told that it will be read sequentially; the lexer reads the
+ * mapping in place. Other files, @e e.g pipes, can't be mapped and
+ * are read by blocks as a stream. Release the reader with
+ * JSON_CloseReader().
+ */
+int JSON_OpenReader(JSON_Reader* reader, const char* path);
+
+
+
+
+/**
+ * @brief Release the file opened by a JSON_Reader.
+ *
+ * @param [in,out] reader The JSON_Reader initialized by
+ * JSON_OpenReader().
+ */
+void JSON_CloseReader(JSON_Reader* reader);
+
+
+
+
+/**
+ * @brief Procedure that free from memory a JSON_Reader.
+ *
+ * @param [in,out] reader The JSON_Reader to free from memory.
+ *
+ * @note The stream is not closed.
+ */
+void JSON_FreeReader(JSON_Reader* reader);
+
+
+
+
+/**
+ * @brief Read the next block of the stream.
+ *
+ * @param [in,out] reader The JSON_Reader to fill.
+ *
+ * @return The number of new bytes available after the cursor. 0 on
+ * end of file or on error.
+ *
+ * @note Every byte after the mark, or after the cursor if there's no
+ * mark, is preserved. The mark, the cursor and the limit are updated
+ * accordingly; pointers to the old block are invalidated.
+ */
+size_t JSON_FillReader(JSON_Reader* reader);
+#endif // _JSON_READER_H
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file records.h
+ *
+ * @brief Interfaces to the parallel parser of JSON Lines.
+ *
+ * The records of JSON Lines are independent once the input is split
+ * on newlines. JSON_ParseRecordsParallel() cuts an input in memory in
+ * chunks of whole lines, and parses the chunks on a pool of threads,
+ * each with its own JSON_Document.
+ */
+
+#ifndef _JSON_RECORDS_H
+#define _JSON_RECORDS_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+#include "parser.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The smallest chunk given to a thread, in bytes. */
+#define JSON_RECORDS_CHUNK (1 << 14)
+
+/** The number of chunks per thread, to balance their load. */
+#define JSON_RECORDS_SPLIT 8
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Parse the JSON Lines of a reader on a pool of threads.
+ *
+ * @param [in,out] reader The JSON_Reader to parse, consumed to its
+ * end.
+ *
+ * @param [in] callback The function called for every record. It
+ * mustn't reset the document it's given, which is only valid during
+ * the call. A non zero value stops the parse and is returned.
+ *
+ * @param [in] ctx The context passed to the callback.
+ *
+ * @param [in] threads The number of threads, or 0 for one per online
+ * processor.
+ *
+ * @param [in] ordered Non zero to call the callback in the order of
+ * the input, one record at a time. Otherwise, the callback is called
+ * concurrently by the threads, in any order, and must be thread safe.
+ *
+ * @param [in] hashFunc, dictSize, listSize Same as JSON_NextRecord().
+ *
+ * @return 0 on success, 1 if a record is invalid, 2 on memory
+ * exhaustion, or the value returned by the callback that stopped the
+ * parse. In order, every record before the one that stopped the parse
+ * has been given to the callback, and none after.
+ *
+ * @note A reader that can't be read in place, @e e.g. a pipe, is
+ * parsed by the calling thread with JSON_ParseRecords().
+ */
+int JSON_ParseRecordsParallel(JSON_Reader*    reader,
+                              JSON_RecordFunc callback,
+                              void*           ctx,
+                              size_t          threads,
+                              int             ordered,
+                              JSON_Hash       hashFunc,
+                              size_t          dictSize,
+                              size_t          listSize);
+#endif // _JSON_RECORDS_H
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sax.h
+ *
+ * @brief Interfaces to the event parser.
+ *
+ * JSON_ParseEvents() reads a value with the lexer and calls a
+ * JSON_Handler for every event, in the order of the input, instead of
+ * building a tree. It only keeps the kind of every open container, so
+ * an input read as a stream is parsed in memory bounded by its depth
+ * and its longest string.
+ *
+ * A tree of JSON_Type is one consumer of these events, see
+ * JSON_BuildReader(); it shares the lexer with the Bison parser.
+ */
+
+#ifndef _JSON_SAX_H
+#define _JSON_SAX_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+#include "allocator.h"
+#include "json.h"
+#include "number.h"
+#include "reader.h"
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Handler
+ *
+ * @brief A table of event callbacks and their context.
+ *
+ * Every callback receives @b ctx as its first argument, and returns 0
+ * to go on. A positive value stops the parse and is returned by
+ * JSON_ParseEvents(); return 2 on memory exhaustion. A @b NULL
+ * callback ignores its event.
+ *
+ * The label of an entry is given by @b key, right before its value.
+ */
+typedef struct JSON_Handler
+{
+  int (*start_dict) (void* ctx);                           /**< '{' */
+  int (*end_dict)   (void* ctx);                           /**< '}' */
+  int (*start_list) (void* ctx);                           /**< '[' */
+  int (*end_list)   (void* ctx);                           /**< ']' */
+  int (*key)        (void* ctx, char* label, size_t len);  /**< A label. */
+  int (*string)     (void* ctx, char* str, size_t len);    /**< A string. */
+  int (*number)     (void* ctx, const JSON_Number* num);   /**< A number. */
+  int (*boolean)    (void* ctx, int value);                /**< -1 for false,
+                                                            * 1 for true and
+                                                            * 0 for null. */
+
+  const JSON_Allocator* alloc; /**< The allocator of the strings and
+                                * labels given to the callbacks, which
+                                * then own them. If @b NULL, they're
+                                * in a buffer of the parser, only
+                                * valid during the callback. */
+
+  void* ctx; /**< The user context. */
+} JSON_Handler;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Parse a value from a reader, as events.
+ *
+ * @param [in,out] reader The JSON_Reader to parse.
+ *
+ * @param [in] handler The callbacks of the events.
+ *
+ * @return 0 on success, 1 if the input is invalid, 2 on memory
+ * exhaustion, or the value returned by the callback that stopped the
+ * parse.
+ *
+ * @note Like the parsers, the input is a dict or a list, and every
+ * dict and list has at least one element. An empty input is valid,
+ * and has no event.
+ */
+int JSON_ParseEvents(JSON_Reader* reader, const JSON_Handler* handler);
+
+
+
+
+/**
+ * @brief Parse a value from a reader into a JSON_Type, built from the
+ * events of JSON_ParseEvents().
+ *
+ * @param [out] type The value parsed, or @b NULL if the input is empty.
+ *
+ * @param [in,out] reader The JSON_Reader to parse.
+ *
+ * @param [in] alloc The JSON_Allocator of the tree, or @b NULL for the
+ * default one.
+ *
+ * @param [in] hash The hash function of the dicts, or @b NULL for
+ * JSON_DefaultHash().
+ *
+ * @param [in] dictSize The initial size of the dicts.
+ *
+ * @param [in] listSize The initial size of the lists.
+ *
+ * @return Same as JSON_ParseEvents(). On failure, nothing is left to
+ * release.
+ */
+int JSON_BuildReader(JSON_Type**           type,
+                     JSON_Reader*          reader,
+                     const JSON_Allocator* alloc,
+                     JSON_HashFunc         hash,
+                     size_t                dictSize,
+                     size_t                listSize);
+#endif // _JSON_SAX_H
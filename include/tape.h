@@ -0,0 +1,352 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tape.h
+ *
+ * @brief Interfaces to JSON_Tape structure.
+ *
+ * A JSON_Tape is a read-only tree laid out in a single array of 64
+ * bits words, in the order of the input. Every value is one word: its
+ * JSON_Types in the upper 8 bits and a payload in the lower 56 bits.
+ *
+ * - A string holds the offset of its characters in the strings
+ *   buffer, where they're stored after their 32 bits length and
+ *   followed by a NUL.
+ *
+ * - A number holds the index of its 64 bits in the numbers buffer.
+ *
+ * - A boolean holds its value plus one.
+ *
+ * - A dict or a list holds the index one past its last word in its
+ *   lower 32 bits, and its number of elements, saturated, above.
+ *   Its elements follow it, and it's closed by a JSON_NONE word that
+ *   holds the index of the opening one. In a dict, every value is
+ *   preceded by its label: a string tagged JSON_TAPE_LABEL.
+ *
+ * The word 0 is the root of the tape, and holds the number of
+ * words. The value parsed, if any, starts at word 1. Values are
+ * referred to by the index of their first word; the index 0 means no
+ * value.
+ *
+ * Tapes are filled straight from the lexer by JSON_ParseTape() and
+ * friends, without JSON_Type nor JSON_Dict. Looking up a label is a
+ * linear scan of the dict.
+ */
+
+#ifndef _JSON_TAPE_H
+#define _JSON_TAPE_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "reader.h"
+#include "type.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The JSON_Types of a word. */
+#define JSON_TAPE_TYPE(word) ((JSON_Types)((word) >> 56))
+
+/** The payload of a word. */
+#define JSON_TAPE_PAYLOAD(word) ((word) & ((UINT64_C(1) << 56) - 1))
+
+/** The type of the words holding the labels of a dict. */
+#define JSON_TAPE_LABEL ((JSON_Types)(JSON_NONE + 1))
+
+/** The number of elements above which a container must be counted. */
+#define JSON_TAPE_MAX_COUNT ((UINT32_C(1) << 24) - 1)
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Tape
+ *
+ * @brief A structure that hold a parsed tree as a tape of words and
+ * its side buffers.
+ *
+ * Words are indexed on 32 bits, so a tape can't hold more than 4 G
+ * words.
+ */
+typedef struct JSON_Tape
+{
+  uint64_t* words; /**< The tape. */
+  size_t    count; /**< The number of words. */
+  size_t    size;  /**< The capacity of words. */
+
+  char*  strings; /**< The lengths and characters of every string. */
+  size_t used;    /**< The number of bytes of strings. */
+  size_t space;   /**< The capacity of strings. */
+
+  uint64_t* numbers; /**< The bits of every number. */
+  size_t    ncount;  /**< The number of numbers. */
+  size_t    nsize;   /**< The capacity of numbers. */
+} JSON_Tape;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Allocate memory for an empty JSON_Tape.
+ *
+ * @return A pointer to the allocated JSON_Tape or @b NULL on failure.
+ */
+JSON_Tape* JSON_MallocTape(void);
+
+
+
+
+/**
+ * @brief Procedure that free from memory a JSON_Tape.
+ *
+ * @param [in,out] tape The JSON_Tape to free from memory.
+ */
+void JSON_FreeTape(JSON_Tape* tape);
+
+
+
+
+/**
+ * @brief Release the tree of a JSON_Tape.
+ *
+ * @param [in,out] tape The JSON_Tape to reset.
+ *
+ * @note The buffers are kept for the next parse.
+ */
+void JSON_ResetTape(JSON_Tape* tape);
+
+
+
+
+/**
+ * @brief Parse a reader into a JSON_Tape.
+ *
+ * @param [in,out] tape The JSON_Tape to fill. It's reset first.
+ *
+ * @param [in,out] reader The JSON_Reader to parse.
+ *
+ * @return 0 on success, 1 if the input is invalid and 2 on memory
+ * exhaustion, like JSON_ParseReader().
+ *
+ * @note Like the parsers, the input is a dict or a list, and every
+ * dict and list has at least one element.
+ */
+int JSON_ParseTape(JSON_Tape* tape, JSON_Reader* reader);
+
+
+
+
+/**
+ * @brief Parse a buffer into a JSON_Tape.
+ *
+ * @param [in,out] tape The JSON_Tape to fill.
+ *
+ * @param [in] buf The buffer to parse, read in place.
+ *
+ * @param [in] len The length of the buffer.
+ *
+ * @return Same as JSON_ParseTape().
+ */
+int JSON_ParseTapeBuffer(JSON_Tape* tape, const char* buf, size_t len);
+
+
+
+
+/**
+ * @brief Parse a file into a JSON_Tape.
+ *
+ * @param [in,out] tape The JSON_Tape to fill.
+ *
+ * @param [in] path The path of the file to parse, opened with
+ * JSON_OpenReader().
+ *
+ * @return Same as JSON_ParseTape(), or -1 if the file can't be opened.
+ */
+int JSON_ParseTapeFile(JSON_Tape* tape, const char* path);
+
+
+
+
+/**
+ * @brief Get the root value of a JSON_Tape.
+ *
+ * @return The index of the root value, or 0 if the tape is empty.
+ */
+size_t JSON_TapeRoot(const JSON_Tape* tape);
+
+
+
+
+/**
+ * @brief Get the type of a value.
+ *
+ * @param [in] tape The JSON_Tape of the value.
+ *
+ * @param [in] i The index of the value.
+ *
+ * @return The JSON_Types of the value.
+ */
+JSON_Types JSON_TapeType(const JSON_Tape* tape, size_t i);
+
+
+
+
+/**
+ * @brief Get the index of the value after another one.
+ *
+ * @param [in] tape The JSON_Tape of the value.
+ *
+ * @param [in] i The index of the value.
+ *
+ * @return The index one past the last word of the value.
+ */
+size_t JSON_TapeSkip(const JSON_Tape* tape, size_t i);
+
+
+
+
+/**
+ * @brief Get the number of elements of a dict or a list, or the length
+ * of a string.
+ *
+ * @param [in] tape The JSON_Tape of the value.
+ *
+ * @param [in] i The index of the value.
+ *
+ * @return The size of the value, 0 for other types.
+ *
+ * @note Containers of more than JSON_TAPE_MAX_COUNT elements are
+ * counted one element at a time.
+ */
+size_t JSON_TapeSize(const JSON_Tape* tape, size_t i);
+
+
+
+
+/**
+ * @brief Iterate over the elements of a dict or a list.
+ *
+ * @param [in] tape The JSON_Tape of the container.
+ *
+ * @param [in] i The index of the container.
+ *
+ * @param [in] prev The index of the previous element, or 0 to start.
+ *
+ * @return The index of the next element, or 0 past the last one. In a
+ * dict, the elements are the values; see JSON_TapeLabel().
+ */
+size_t JSON_TapeNext(const JSON_Tape* tape, size_t i, size_t prev);
+
+
+
+
+/**
+ * @brief Look a label up in a dict.
+ *
+ * @param [in] tape The JSON_Tape of the dict.
+ *
+ * @param [in] i The index of the dict.
+ *
+ * @param [in] label The label to look for.
+ *
+ * @return The index of the first value with that label, or 0.
+ */
+size_t JSON_TapeGet(const JSON_Tape* tape, size_t i, const char* label);
+
+
+
+
+/**
+ * @brief Get an element of a list.
+ *
+ * @param [in] tape The JSON_Tape of the list.
+ *
+ * @param [in] i The index of the list.
+ *
+ * @param [in] n The position of the element.
+ *
+ * @return The index of the element, or 0 if @b n is out of range.
+ *
+ * @note Elements are skipped one at a time; iterate with
+ * JSON_TapeNext() instead of calling it in a loop.
+ */
+size_t JSON_TapeAt(const JSON_Tape* tape, size_t i, size_t n);
+
+
+
+
+/**
+ * @brief Get the label of a value in a dict.
+ *
+ * @return The label, or @b NULL if the value isn't in a dict.
+ */
+const char* JSON_TapeLabel(const JSON_Tape* tape, size_t i);
+
+
+
+
+/**
+ * @brief Get the characters of a string, NUL terminated.
+ */
+const char* JSON_TapeString(const JSON_Tape* tape, size_t i);
+
+
+
+
+/**
+ * @brief Get an integer, of type JSON_INTEGER.
+ */
+int64_t JSON_TapeInteger(const JSON_Tape* tape, size_t i);
+
+
+
+
+/**
+ * @brief Get an unsigned integer, of type JSON_UNSIGNED.
+ */
+uint64_t JSON_TapeUnsigned(const JSON_Tape* tape, size_t i);
+
+
+
+
+/**
+ * @brief Get a number as a double, converted if it's an integer.
+ */
+double JSON_TapeNumber(const JSON_Tape* tape, size_t i);
+
+
+
+
+/**
+ * @brief Get a boolean, -1 for false, 1 for true and 0 for null.
+ */
+int JSON_TapeBool(const JSON_Tape* tape, size_t i);
+#endif // _JSON_TAPE_H
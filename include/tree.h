@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tree.h
+ *
+ * @brief Interfaces to the building of JSON_Type trees, value by value.
+ *
+ * A JSON_Tree keeps a stack of the open containers, and attaches every
+ * value to the innermost one as soon as it's given. The hand-written
+ * parser, see descent.h, and the builder of events, see sax.h, only
+ * read their input and tell the tree what comes next.
+ */
+
+#ifndef _JSON_TREE_H
+#define _JSON_TREE_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdlib.h>
+
+#include "allocator.h"
+#include "intern.h"
+#include "json.h"
+#include "number.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The depth of containers before the stack is allocated. */
+#define JSON_TREE_STACK 64
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @struct JSON_Tree
+ *
+ * @brief A tree being built.
+ */
+typedef struct JSON_Tree
+{
+  JSON_Type* root;  /**< The value built, owns every other. */
+  JSON_Key   label; /**< The label of the next value, if in a dict. */
+
+  const JSON_Allocator* alloc;    /**< The allocator of the tree. */
+  JSON_InternTable*     keys;     /**< The labels, or @b NULL. */
+  JSON_HashFunc         hashFunc; /**< The hash function of the dicts. */
+  size_t                dictSize; /**< The initial size of the dicts. */
+  size_t                listSize; /**< The initial size of the lists. */
+
+  JSON_Type** stack; /**< The open containers. */
+  size_t      depth; /**< The number of open containers. */
+  size_t      size;  /**< The capacity of stack. */
+
+  JSON_Type* inline_stack[JSON_TREE_STACK]; /**< The stack until it
+                                             * grows. */
+} JSON_Tree;
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+/**
+ * @brief Start an empty tree.
+ *
+ * @param [out] tree The JSON_Tree to start, released by
+ * JSON_ReleaseTree().
+ *
+ * @param [in] alloc The JSON_Allocator of the tree.
+ *
+ * @param [in] hashFunc, dictSize, listSize Same as JSON_ParseReader().
+ *
+ * @param [in,out] keys The JSON_InternTable of the labels, or @b NULL
+ * to keep every label as given.
+ */
+void JSON_InitTree(JSON_Tree*            tree,
+                   const JSON_Allocator* alloc,
+                   JSON_HashFunc         hashFunc,
+                   size_t                dictSize,
+                   size_t                listSize,
+                   JSON_InternTable*     keys);
+
+
+
+
+/**
+ * @brief Open a dict or a list, attached empty, in which the next
+ * values go.
+ *
+ * @return 0 on success, 2 on failure.
+ */
+int JSON_TreeOpen(JSON_Tree* tree, JSON_Types type);
+
+
+
+
+/**
+ * @brief Set the label of the next value, interned if the tree has a
+ * table of labels.
+ *
+ * @param [in] label The label, allocated by the allocator of the tree,
+ * which then owns it.
+ *
+ * @param [in] length The length of the label.
+ */
+void JSON_TreeLabel(JSON_Tree* tree, char* label, size_t length);
+
+
+
+
+/**
+ * @brief Add a string.
+ *
+ * @param [in] str The string, allocated by the allocator of the tree,
+ * which then owns it, even on failure.
+ *
+ * @return 0 on success, 2 on failure.
+ */
+int JSON_TreeString(JSON_Tree* tree, char* str);
+
+
+
+
+/**
+ * @brief Add a number.
+ *
+ * @return 0 on success, 2 on failure.
+ */
+int JSON_TreeNumber(JSON_Tree* tree, const JSON_Number* number);
+
+
+
+
+/**
+ * @brief Add a boolean, or null.
+ *
+ * @param [in] bool -1 for false, 1 for true and 0 for null.
+ *
+ * @return 0 on success, 2 on failure.
+ */
+int JSON_TreeBool(JSON_Tree* tree, int bool);
+
+
+
+
+/**
+ * @brief Release what's left of the building of a tree.
+ *
+ * @param [in] failed Non zero if the build failed: then the tree and
+ * its pending label are released too.
+ *
+ * @return The value built, or @b NULL if there's none or on failure.
+ */
+JSON_Type* JSON_ReleaseTree(JSON_Tree* tree, int failed);
+#endif // _JSON_TREE_H
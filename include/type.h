@@ -28,6 +28,7 @@
 /*=============================================================================+
  |                                  Includes                                   |
  +=============================================================================*/
+#include <stdint.h>
 #include <stdlib.h>
 
 
@@ -36,6 +37,7 @@
 /*=============================================================================+
  |                            Forward Declarations                             |
  +=============================================================================*/
+struct JSON_Allocator;
 struct JSON_Dict;
 struct JSON_List;
 
@@ -57,6 +59,8 @@ typedef enum JSON_Types
   JSON_STRING,  /**< char* */
   JSON_DICT,    /**< JSON_Dict */
   JSON_LIST,    /**< JSON_List*/
+  JSON_INTEGER, /**< int64_t */
+  JSON_UNSIGNED,/**< uint64_t, only if larger than INT64_MAX */
   JSON_NONE
 } JSON_Types;
 
@@ -71,7 +75,7 @@ typedef enum JSON_Types
  *
  * @brief A structure representing the basic type in JSON.
  *
- * The structure has 4 members.
+ * The structure has 5 members.
  *
  * - A string, called @b label, that represent the key passed to hash
  *   function, if the JSON_Type is in a JSON_Dict.
@@ -82,9 +86,9 @@ typedef enum JSON_Types
  * - A anonymous union, that can be one of the diffrent types defined
  *   by JSON_Types, excepted JSON_NONE.
  *
- * - A pointer to a JSON_Type, called @b next, that represented the
- *   the next JSON_Type, if any, in the linked list, if the instance
- *   is in a JSON_Dict.
+ * - The @b hash of the label and its @b length, set by the JSON_Dict
+ *   the instance is in. Lookups compare them before the labels, and
+ *   the dict never hash a label twice.
  */
 typedef struct JSON_Type
 {
@@ -92,17 +96,21 @@ typedef struct JSON_Type
 
   JSON_Types type; /**< Integer representing which type is hold in the
                     * annonymous union*/
+
+  uint32_t length; /**< The length of the label, if in a JSON_Dict. */
+
   union
   {
     int bool;
     double num;
+    int64_t integer;
+    uint64_t uinteger;
     char* str;
     struct JSON_Dict* dict;
     struct JSON_List* list;
   }; /**< Annonymous union */
 
-  struct JSON_Type* next; /**< The next JSON_Type in the linked list,
-                           * if in a JSON_Dict. */
+  size_t hash; /**< The hash of the label, if in a JSON_Dict. */
 } JSON_Type;
 
 
@@ -126,6 +134,29 @@ JSON_Type* JSON_MallocType(const char* label, JSON_Types type);
 
 
 
+/**
+ * @brief Allocate memory for a JSON_Type with a JSON_Allocator.
+ *
+ * @param [in] alloc The JSON_Allocator to use, or @b NULL for the
+ * default one.
+ *
+ * @param [in] label The label of the JSON_Type, copied with the
+ * allocator.
+ *
+ * @param [in] type The JSON_Types to use.
+ *
+ * @return Same as JSON_MallocType().
+ *
+ * @note Such JSON_Type must be released with JSON_FreeTypeWith() and
+ * the same allocator.
+ */
+JSON_Type* JSON_MallocTypeWith(const struct JSON_Allocator* alloc,
+                               const char* label,
+                               JSON_Types type);
+
+
+
+
 /**
  * @brief Procedure that free from memory a JSON_Type.
  *
@@ -135,4 +166,18 @@ JSON_Type* JSON_MallocType(const char* label, JSON_Types type);
  * instance.
  */
 void JSON_FreeType(struct JSON_Type* type);
+
+
+
+
+/**
+ * @brief Procedure that free from memory a JSON_Type with a
+ * JSON_Allocator.
+ *
+ * @param [in] alloc The JSON_Allocator the JSON_Type was allocated
+ * with, or @b NULL for the default one.
+ *
+ * @param [in,out] type The JSON_Type to free from memory.
+ */
+void JSON_FreeTypeWith(const struct JSON_Allocator* alloc, struct JSON_Type* type);
 #endif // _JSON_TYPE_H
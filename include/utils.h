@@ -33,18 +33,6 @@ typedef struct parser_option
   size_t lsize;
 } parser_option;
 
-
-
-
-static size_t dummy_hash(JSON_HashKey key)
-{
-  size_t hash = 0;
-
-  while (key)
-    hash += (size_t)*key++;
-
-  return hash;
-}
 /*=============================================================================+
  |                               Parser Wrapper                                |
  +=============================================================================*/
@@ -52,16 +40,9 @@ int fparse(type** obj_pp,
            FILE* fd,
            parser_option* options)
 {
-  static hash_t hashFunc = NULL;
-  static size_t dictSize = 256;
-  static size_t listSize = 256;
-
-  if (options)
-  {
-    hashFunc = options->fn;
-    dictSize = options->dsize;
-    listSize = options->lsize;
-  }
+  hash_t hashFunc = options ? options->fn    : NULL;
+  size_t dictSize = options ? options->dsize : JSON_DICT_MIN_SIZE;
+  size_t listSize = options ? options->lsize : 256;
 
   return JSON_parse(obj_pp, fd, hashFunc, dictSize, listSize);
 }
@@ -73,34 +54,18 @@ int sparse(type** obj_pp,
            char* str,
            parser_option* options)
 {
-  static hash_t hashFunc = dummy_hash;
-  static size_t dictSize = 256;
-  static size_t listSize = 256;
-
-  if (options)
-  {
-    hashFunc = options->fn;
-    dictSize = options->dsize;
-    listSize = options->lsize;
-  }
+  hash_t hashFunc = options ? options->fn    : NULL;
+  size_t dictSize = options ? options->dsize : JSON_DICT_MIN_SIZE;
+  size_t listSize = options ? options->lsize : 256;
 
   int retval = 0;
-  FILE* fd   = fmemopen(str, strlen(str), "r");
 
-  if (!fd)
-  {
-    perror("fmemopen failed");
-    retval = -1;
-  }
-
-  if (JSON_parse(obj_pp, fd, hashFunc, dictSize, listSize))
+  if (JSON_ParseBuffer(obj_pp, str, strlen(str), hashFunc, dictSize, listSize))
   {
     fprintf(stderr, "Bison failed parsing string at adress %p\n", str);
     retval = -1;
   }
 
-  fclose(fd);
-
   return retval;
 }
 /*=============================================================================+
@@ -120,4 +85,8 @@ int sparse(type** obj_pp,
 #define tnumber(PTR,VALUE) \
   JSON_Type* PTR = JSON_MallocType(NULL, JSON_NUMBER); \
   if (PTR) PTR->num=VALUE
+
+#define tinteger(PTR,VALUE) \
+  JSON_Type* PTR = JSON_MallocType(NULL, JSON_INTEGER); \
+  if (PTR) PTR->integer=VALUE
 #endif // _JSON_UTILS_H
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file allocator.c
+ *
+ * @brief JSON_Allocator structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <string.h>
+
+#include "allocator.h"
+#include "commons.h"
+
+
+
+
+/*=============================================================================+
+ |                             Function Prototypes                             |
+ +=============================================================================*/
+static void* libc_alloc(void* ctx, size_t size);
+static void* libc_realloc(void* ctx, void* ptr, size_t old, size_t size);
+static void  libc_free(void* ctx, void* ptr);
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+const JSON_Allocator JSON_DefaultAllocator =
+{
+  libc_alloc,
+  libc_realloc,
+  libc_free,
+  NULL
+};
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+static void* libc_alloc(void* ctx, size_t size)
+{
+  return malloc(size);
+}
+
+
+
+
+static void* libc_realloc(void* ctx, void* ptr, size_t old, size_t size)
+{
+  return realloc(ptr, size);
+}
+
+
+
+
+static void libc_free(void* ctx, void* ptr)
+{
+  free(ptr);
+}
+
+
+
+
+void* JSON_AllocZero(const JSON_Allocator* alloc, size_t size)
+{
+  if (alloc == &JSON_DefaultAllocator)
+    return calloc(1, size);
+
+  void* p = alloc->alloc(alloc->ctx, size);
+
+  if (JSON_likely(p != NULL))
+    memset(p, 0, size);
+
+  return p;
+}
+
+
+
+
+char* JSON_AllocString(const JSON_Allocator* alloc, const char* str)
+{
+  size_t len = strlen(str) + 1;
+  char*  p   = alloc->alloc(alloc->ctx, len);
+
+  if (JSON_likely(p != NULL))
+    memcpy(p, str, len);
+
+  return p;
+}
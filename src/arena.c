@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file arena.c
+ *
+ * @brief JSON_Arena structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
+#include "commons.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+#define ALIGN_UP(P) \
+  ((char*)(((uintptr_t)(P) + JSON_ARENA_ALIGN - 1) & ~(uintptr_t)(JSON_ARENA_ALIGN - 1)))
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+static void* arena_alloc(void* ctx, size_t size)
+{
+  return JSON_ArenaAlloc(ctx, size);
+}
+
+
+
+
+static void* arena_realloc(void* ctx, void* ptr, size_t old, size_t size)
+{
+  return JSON_ArenaRealloc(ctx, ptr, old, size);
+}
+
+
+
+
+static void arena_free(void* ctx, void* ptr)
+{
+  JSON_ArenaFree(ctx, ptr);
+}
+
+
+
+
+/**
+ * @brief Move to a chunk that can hold an allocation.
+ *
+ * The chunks after the current one are reused if they're large
+ * enough. Otherwise, a new chunk is inserted after the current one.
+ *
+ * @param [in,out] arena The JSON_Arena to grow.
+ *
+ * @param [in] size The size of the allocation.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int next_chunk(JSON_Arena* arena, size_t size)
+{
+  JSON_Chunk* next = arena->current ? arena->current->next : arena->first;
+
+  if (next == NULL || next->size < size + JSON_ARENA_ALIGN)
+  {
+    size_t chunk_size = arena->chunk;
+
+    if (chunk_size < size + JSON_ARENA_ALIGN)
+      chunk_size = size + JSON_ARENA_ALIGN;
+
+    /*  An aligned limit, so an aligned cursor never passes it  */
+    chunk_size = (chunk_size + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1);
+
+    JSON_Chunk* chunk = malloc(sizeof(JSON_Chunk) + chunk_size);
+
+    if (JSON_unlikely(chunk == NULL))
+      return -1;
+
+    chunk->size = chunk_size;
+    chunk->next = next;
+
+    if (arena->current)
+      arena->current->next = chunk;
+    else
+      arena->first = chunk;
+
+    if (arena->chunk < JSON_ARENA_MAX_CHUNK)
+      arena->chunk *= 2;
+
+    ++arena->count;
+
+    next = chunk;
+  }
+
+  arena->current = next;
+  arena->cursor  = next->data;
+  arena->limit   = next->data + next->size;
+
+  return 0;
+}
+
+
+
+
+JSON_Arena* JSON_MallocArena(size_t chunk)
+{
+  JSON_Arena* arena = calloc(1, sizeof(JSON_Arena));
+
+  if (JSON_likely(arena != NULL))
+    arena->chunk = chunk ? chunk : JSON_ARENA_CHUNK;
+
+  return arena;
+}
+
+
+
+
+void JSON_FreeArena(JSON_Arena* arena)
+{
+  if (arena)
+  {
+    JSON_Chunk* chunk = arena->first;
+
+    while (chunk)
+    {
+      JSON_Chunk* next = chunk->next;
+
+      free(chunk);
+      chunk = next;
+    }
+
+    free(arena);
+  }
+}
+
+
+
+
+void JSON_ResetArena(JSON_Arena* arena)
+{
+  arena->current = NULL;
+  arena->cursor  = NULL;
+  arena->limit   = NULL;
+  arena->last    = NULL;
+}
+
+
+
+
+void* JSON_ArenaAlloc(JSON_Arena* arena, size_t size)
+{
+  char* p = ALIGN_UP(arena->cursor);
+
+  if (JSON_unlikely(arena->cursor == NULL || size > (size_t)(arena->limit - p)))
+  {
+    if (next_chunk(arena, size) != 0)
+      return NULL;
+
+    p = ALIGN_UP(arena->cursor);
+  }
+
+  arena->cursor = p + size;
+  arena->last   = p;
+
+  return p;
+}
+
+
+
+
+void* JSON_ArenaCalloc(JSON_Arena* arena, size_t n, size_t size)
+{
+  if (JSON_unlikely(size && n > SIZE_MAX / size))
+    return NULL;
+
+  void* p = JSON_ArenaAlloc(arena, n * size);
+
+  if (JSON_likely(p != NULL))
+    memset(p, 0, n * size);
+
+  return p;
+}
+
+
+
+
+void* JSON_ArenaRealloc(JSON_Arena* arena, void* ptr, size_t old, size_t size)
+{
+  /*  Grow in place  */
+  if (ptr != NULL && ptr == arena->last && size <= (size_t)(arena->limit - (char*)ptr))
+  {
+    arena->cursor = (char*)ptr + size;
+    return ptr;
+  }
+
+  void* p = JSON_ArenaAlloc(arena, size);
+
+  if (JSON_likely(p != NULL) && ptr != NULL)
+    memcpy(p, ptr, old < size ? old : size);
+
+  return p;
+}
+
+
+
+
+void JSON_ArenaFree(JSON_Arena* arena, void* ptr)
+{
+  if (ptr != NULL && ptr == arena->last)
+  {
+    arena->cursor = ptr;
+    arena->last   = NULL;
+  }
+}
+
+
+
+
+void JSON_InitArenaAllocator(JSON_Allocator* alloc, JSON_Arena* arena)
+{
+  alloc->alloc   = arena_alloc;
+  alloc->realloc = arena_realloc;
+  alloc->free    = arena_free;
+  alloc->ctx     = arena;
+}
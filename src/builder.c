@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file builder.c
+ *
+ * @brief Builder of JSON_Type trees from the events of the event
+ * parser.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include "sax.h"
+#include "tree.h"
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+static int start_dict(void* ctx)
+{
+  return JSON_TreeOpen(ctx, JSON_DICT);
+}
+
+
+
+
+static int start_list(void* ctx)
+{
+  return JSON_TreeOpen(ctx, JSON_LIST);
+}
+
+
+
+
+static int end_container(void* ctx)
+{
+  --((JSON_Tree*)ctx)->depth;
+
+  return 0;
+}
+
+
+
+
+static int key(void* ctx, char* label, size_t len)
+{
+  JSON_TreeLabel(ctx, label, len);
+
+  return 0;
+}
+
+
+
+
+static int string(void* ctx, char* str, size_t len)
+{
+  return JSON_TreeString(ctx, str);
+}
+
+
+
+
+static int number(void* ctx, const JSON_Number* num)
+{
+  return JSON_TreeNumber(ctx, num);
+}
+
+
+
+
+static int boolean(void* ctx, int bool)
+{
+  return JSON_TreeBool(ctx, bool);
+}
+
+
+
+
+int JSON_BuildReader(JSON_Type** type,
+                     JSON_Reader* reader,
+                     const JSON_Allocator* alloc,
+                     JSON_HashFunc hash,
+                     size_t dictSize,
+                     size_t listSize)
+{
+  if (alloc == NULL)
+    alloc = &JSON_DefaultAllocator;
+
+  JSON_Tree tree;
+
+  JSON_InitTree(&tree, alloc, hash, dictSize, listSize, NULL);
+
+  JSON_Handler handler =
+  {
+    .start_dict = start_dict,
+    .end_dict   = end_container,
+    .start_list = start_list,
+    .end_list   = end_container,
+    .key        = key,
+    .string     = string,
+    .number     = number,
+    .boolean    = boolean,
+    .alloc      = alloc,
+    .ctx        = &tree,
+  };
+
+  int retval = JSON_ParseEvents(reader, &handler);
+
+  *type = JSON_ReleaseTree(&tree, retval != 0);
+
+  return retval;
+}
@@ -0,0 +1,483 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cursor.c
+ *
+ * @brief JSON_Cursor structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <string.h>
+
+#include "allocator.h"
+#include "commons.h"
+#include "cursor.h"
+#include "parser.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+#define WS          0x01 /**< White space */
+#define DELIMITER   0x02 /**< Ends a scalar */
+#define STRUCTURAL  0x04 /**< Opens or closes a container, or a string */
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+/** Class of every characters, as a mask of WS, DELIMITER and STRUCTURAL. */
+static const unsigned char classes[256] =
+{
+  [' ']  = WS | DELIMITER,
+  ['\t'] = WS | DELIMITER,
+  ['\r'] = WS | DELIMITER,
+  ['\n'] = WS | DELIMITER,
+  [',']  = DELIMITER,
+  [':']  = DELIMITER,
+  ['"']  = STRUCTURAL,
+  ['{']  = STRUCTURAL,
+  ['[']  = STRUCTURAL,
+  ['}']  = DELIMITER | STRUCTURAL,
+  [']']  = DELIMITER | STRUCTURAL,
+};
+
+
+
+
+/*=============================================================================+
+ |                                 Prototypes                                  |
+ +=============================================================================*/
+int JSON_yylex(JSON_YYSTYPE* val_p, JSON_YYLTYPE* loc_p, JSON_Reader* reader,
+               const JSON_Allocator* alloc);
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @return The first character after the white spaces at @b p.
+ */
+static const char* skip_ws(const char* p, const char* end)
+{
+  while (p < end && (classes[(unsigned char)*p] & WS))
+    ++p;
+
+  return p;
+}
+
+
+
+
+/**
+ * @brief Skip a string.
+ *
+ * @param [in] p The opening quote.
+ *
+ * @return One past the closing quote, or @b NULL if there's none.
+ */
+static const char* skip_string(const char* p, const char* end)
+{
+  for (++p; p < end; )
+  {
+    const char* q = memchr(p, '"', end - p);
+
+    if (JSON_unlikely(q == NULL))
+      return NULL;
+
+    /*  Escaped by an odd number of backslashes  */
+    const char* b = q;
+
+    while (b > p && b[-1] == '\\')
+      --b;
+
+    if (((q - b) & 1) == 0)
+      return q + 1;
+
+    p = q + 1;
+  }
+
+  return NULL;
+}
+
+
+
+
+/**
+ * @brief Skip a value, matching the brackets of a container.
+ *
+ * @param [in] p The first character of the value.
+ *
+ * @return One past the value, or @b NULL if it's not closed.
+ */
+static const char* skip_value(const char* p, const char* end)
+{
+  if (*p == '"')
+    return skip_string(p, end);
+
+  if (*p != '{' && *p != '[')
+  {
+    while (p < end && !(classes[(unsigned char)*p] & DELIMITER))
+      ++p;
+
+    return p;
+  }
+
+  size_t depth = 0;
+
+  while (p < end)
+  {
+    unsigned char c = *p;
+
+    if (JSON_likely(!(classes[c] & STRUCTURAL)))
+    {
+      ++p;
+      continue;
+    }
+
+    if (c == '"')
+    {
+      p = skip_string(p, end);
+
+      if (JSON_unlikely(p == NULL))
+        return NULL;
+
+      continue;
+    }
+
+    if (c == '{' || c == '[')
+      ++depth;
+    else if (--depth == 0)
+      return p + 1;
+
+    ++p;
+  }
+
+  return NULL;
+}
+
+
+
+
+/**
+ * @brief Read the token at @b p with the lexer.
+ *
+ * @return The token, as returned by JSON_yylex().
+ */
+static int lex(const char* p, const char* end, JSON_YYSTYPE* val)
+{
+  JSON_Reader  reader;
+  JSON_YYLTYPE loc = {1, 1, 1, 1};
+
+  JSON_InitReader(&reader, p, end - p);
+
+  return JSON_yylex(val, &loc, &reader, &JSON_DefaultAllocator);
+}
+
+
+
+
+int JSON_OpenCursor(JSON_Cursor* cursor, const char* buf, size_t len)
+{
+  cursor->end   = buf + len;
+  cursor->at    = skip_ws(buf, cursor->end);
+  cursor->label = NULL;
+
+  if (cursor->at == cursor->end)
+  {
+    cursor->at = NULL;
+    return -1;
+  }
+
+  return 0;
+}
+
+
+
+
+JSON_Types JSON_CursorType(const JSON_Cursor* cursor)
+{
+  switch (*cursor->at)
+  {
+  case '{':
+    return JSON_DICT;
+  case '[':
+    return JSON_LIST;
+  case '"':
+    return JSON_STRING;
+  case 't':
+  case 'f':
+  case 'n':
+    return JSON_BOOLEAN;
+  case '-':
+  case '0' ... '9':
+    return JSON_NUMBER;
+  default:
+    return JSON_NONE;
+  }
+}
+
+
+
+
+int JSON_CursorNext(const JSON_Cursor* container, JSON_Cursor* element)
+{
+  const char* end   = container->end;
+  char        open  = *container->at;
+  char        close = open == '{' ? '}' : ']';
+  const char* p;
+
+  if (open != '{' && open != '[')
+    return -1;
+
+  if (element->at == NULL)
+  {
+    p = skip_ws(container->at + 1, end);
+
+    if (p < end && *p == close)
+      return -1;
+  }
+  else
+  {
+    p = skip_value(element->at, end);
+
+    if (JSON_unlikely(p == NULL))
+      return -1;
+
+    p = skip_ws(p, end);
+
+    /*  The end of the container, or invalid  */
+    if (p == end || *p != ',')
+      return -1;
+
+    p = skip_ws(p + 1, end);
+  }
+
+  const char* label = NULL;
+
+  if (open == '{')
+  {
+    if (p == end || *p != '"')
+      return -1;
+
+    label = p;
+    p     = skip_string(p, end);
+
+    if (JSON_unlikely(p == NULL))
+      return -1;
+
+    p = skip_ws(p, end);
+
+    if (p == end || *p != ':')
+      return -1;
+
+    p = skip_ws(p + 1, end);
+  }
+
+  if (p == end)
+    return -1;
+
+  element->at    = p;
+  element->end   = end;
+  element->label = label;
+
+  return 0;
+}
+
+
+
+
+int JSON_CursorGet(const JSON_Cursor* dict, const char* label, JSON_Cursor* value)
+{
+  size_t      len     = strlen(label);
+  JSON_Cursor element = {NULL};
+
+  if (*dict->at != '{')
+    return -1;
+
+  while (JSON_CursorNext(dict, &element) == 0)
+  {
+    const char* raw  = element.label + 1;
+    size_t      size = skip_string(element.label, element.end) - 1 - raw;
+
+    /*  Compare in place, unless there's an escape to decode  */
+    if (JSON_likely(memchr(raw, '\\', size) == NULL))
+    {
+      if (size != len || memcmp(raw, label, len) != 0)
+        continue;
+    }
+    else
+    {
+      char* decoded = JSON_CursorLabel(&element);
+      int   equal   = decoded && strcmp(decoded, label) == 0;
+
+      free(decoded);
+
+      if (!equal)
+        continue;
+    }
+
+    *value = element;
+
+    return 0;
+  }
+
+  return -1;
+}
+
+
+
+
+int JSON_CursorAt(const JSON_Cursor* list, size_t n, JSON_Cursor* value)
+{
+  JSON_Cursor element = {NULL};
+
+  if (*list->at != '[')
+    return -1;
+
+  while (JSON_CursorNext(list, &element) == 0)
+  {
+    if (n-- == 0)
+    {
+      *value = element;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+
+
+
+char* JSON_CursorLabel(const JSON_Cursor* cursor)
+{
+  JSON_YYSTYPE val;
+
+  if (cursor->label == NULL || lex(cursor->label, cursor->end, &val) != STR)
+    return NULL;
+
+  return val.str;
+}
+
+
+
+
+char* JSON_CursorString(const JSON_Cursor* cursor)
+{
+  JSON_YYSTYPE val;
+
+  if (*cursor->at != '"' || lex(cursor->at, cursor->end, &val) != STR)
+    return NULL;
+
+  return val.str;
+}
+
+
+
+
+int JSON_CursorNumber(const JSON_Cursor* cursor, JSON_Number* number)
+{
+  JSON_YYSTYPE val;
+
+  /*  Not lexed, a string would be copied for nothing  */
+  if (*cursor->at == '"' || lex(cursor->at, cursor->end, &val) != NUM)
+    return -1;
+
+  *number = val.number;
+
+  return 0;
+}
+
+
+
+
+int JSON_CursorBool(const JSON_Cursor* cursor, int* value)
+{
+  JSON_YYSTYPE val;
+
+  /*  Not lexed, a string would be copied for nothing  */
+  if (*cursor->at == '"' || lex(cursor->at, cursor->end, &val) != BOOL)
+    return -1;
+
+  *value = val.bool;
+
+  return 0;
+}
+
+
+
+
+JSON_Type* JSON_CursorValue(const JSON_Cursor* cursor)
+{
+  JSON_Type*  type = NULL;
+  JSON_Number number;
+  int         value;
+
+  switch (JSON_CursorType(cursor))
+  {
+  case JSON_DICT:
+  case JSON_LIST:
+  {
+    const char* stop = skip_value(cursor->at, cursor->end);
+
+    if (stop == NULL
+        || JSON_ParseBuffer(&type, cursor->at, stop - cursor->at, NULL,
+                            JSON_DICT_MIN_SIZE, 256) != 0)
+    {
+      JSON_FreeType(type);
+      return NULL;
+    }
+
+    return type;
+  }
+  case JSON_STRING:
+  {
+    char* str = JSON_CursorString(cursor);
+
+    if (str && (type = JSON_MallocType(NULL, JSON_STRING)) != NULL)
+      type->str = str;
+    else
+      free(str);
+
+    return type;
+  }
+  case JSON_NUMBER:
+    if (JSON_CursorNumber(cursor, &number) == 0
+        && (type = JSON_MallocType(NULL, number.type)) != NULL)
+      type->uinteger = number.uinteger;
+
+    return type;
+  case JSON_BOOLEAN:
+    if (JSON_CursorBool(cursor, &value) == 0
+        && (type = JSON_MallocType(NULL, JSON_BOOLEAN)) != NULL)
+      type->bool = value;
+
+    return type;
+  default:
+    return NULL;
+  }
+}
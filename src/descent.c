@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file descent.c
+ *
+ * @brief Hand-written parser implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "commons.h"
+#include "descent.h"
+#include "tree.h"
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @brief The state of a parse.
+ */
+typedef struct Parser
+{
+  JSON_Reader* reader;
+  JSON_Tree    tree;
+
+  JSON_YYSTYPE val;
+  JSON_YYLTYPE loc;
+} Parser;
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+#ifdef JSON_DESCENT_DEFAULT
+static JSON_ParserEngine default_engine = JSON_PARSER_DESCENT;
+#else
+static JSON_ParserEngine default_engine = JSON_PARSER_BISON;
+#endif
+
+
+
+
+/*=============================================================================+
+ |                                 Prototypes                                  |
+ +=============================================================================*/
+int JSON_yylex(JSON_YYSTYPE* val_p, JSON_YYLTYPE* loc_p, JSON_Reader* reader,
+               const JSON_Allocator* alloc);
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+static inline int lex(Parser* parser)
+{
+  return JSON_yylex(&parser->val, &parser->loc, parser->reader, parser->tree.alloc);
+}
+
+
+
+
+/**
+ * @brief Reject a token.
+ *
+ * @return -1, for a syntax error.
+ */
+static int unexpected(Parser* parser, int token)
+{
+  /*  Nobody will own it  */
+  if (token == STR)
+    parser->tree.alloc->free(parser->tree.alloc->ctx, parser->val.str);
+
+  return -1;
+}
+
+
+
+
+/**
+ * @brief Attach a scalar.
+ *
+ * @return 0 on success, -1 if the token isn't a scalar, 2 on failure.
+ */
+static int scalar(Parser* parser, int token)
+{
+  switch (token)
+  {
+  case STR:
+    return JSON_TreeString(&parser->tree, parser->val.str);
+  case NUM:
+    return JSON_TreeNumber(&parser->tree, &parser->val.number);
+  case BOOL:
+    return JSON_TreeBool(&parser->tree, parser->val.bool);
+  default:
+    return unexpected(parser, token);
+  }
+}
+
+
+
+
+/**
+ * @brief Read the label of an entry and its colon.
+ *
+ * @param [in,out] token The token of the label, already read, then
+ * the first token of the value.
+ *
+ * @return 0 on success, -1 on a syntax error.
+ */
+static int read_label(Parser* parser, int* token)
+{
+  if (*token != STR)
+    return unexpected(parser, *token);
+
+  JSON_TreeLabel(&parser->tree, parser->val.str, strlen(parser->val.str));
+
+  if ((*token = lex(parser)) != ':')
+    return unexpected(parser, *token);
+
+  *token = lex(parser);
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Parse a dict or a list at the top level, then the end of the
+ * input.
+ *
+ * Every iteration starts with the first token of a value, then reads
+ * up to the first token of the next one.
+ *
+ * @return Same as JSON_DescentParse(), with -1 for a syntax error.
+ */
+static int parse(Parser* parser)
+{
+  int token = lex(parser);
+  int retval;
+
+  /*  Empty  */
+  if (token == 0)
+    return 0;
+
+  if (token != '{' && token != '[')
+    return unexpected(parser, token);
+
+  for (;;)
+  {
+    if (token == '{')
+    {
+      if ((retval = JSON_TreeOpen(&parser->tree, JSON_DICT)) != 0)
+        return retval;
+
+      /*  A dict has at least one entry  */
+      token = lex(parser);
+
+      if ((retval = read_label(parser, &token)) != 0)
+        return retval;
+
+      continue;
+    }
+
+    if (token == '[')
+    {
+      if ((retval = JSON_TreeOpen(&parser->tree, JSON_LIST)) != 0)
+        return retval;
+
+      /*  And a list one element  */
+      token = lex(parser);
+      continue;
+    }
+
+    if ((retval = scalar(parser, token)) != 0)
+      return retval;
+
+    /*  Then a comma or the end of containers  */
+    for (;;)
+    {
+      JSON_Type* top = parser->tree.stack[parser->tree.depth - 1];
+
+      token = lex(parser);
+
+      if (JSON_likely(token == ','))
+      {
+        token = lex(parser);
+
+        if (top->type == JSON_DICT && (retval = read_label(parser, &token)) != 0)
+          return retval;
+
+        break;
+      }
+
+      if (token != (top->type == JSON_DICT ? '}' : ']'))
+        return unexpected(parser, token);
+
+      if (--parser->tree.depth == 0)
+      {
+        token = lex(parser);
+        return token == 0 ? 0 : unexpected(parser, token);
+      }
+    }
+  }
+}
+
+
+
+
+int JSON_DescentParse(struct JSON_Type** type,
+                      JSON_Reader* reader,
+                      JSON_Hash hashFunc,
+                      size_t dictSize,
+                      size_t listSize,
+                      const JSON_Allocator* alloc,
+                      JSON_InternTable* keys)
+{
+  Parser parser = {.reader = reader, .loc = {1, 1, 1, 1}};
+
+  JSON_InitTree(&parser.tree, alloc, hashFunc, dictSize, listSize, keys);
+
+  int retval = parse(&parser);
+
+  if (retval == -1)
+  {
+    fprintf(stderr, "syntax error at %d.%d-%d.%d\n",
+            parser.loc.first_line, parser.loc.last_line,
+            parser.loc.first_column, parser.loc.last_column);
+    retval = 1;
+  }
+
+  JSON_Type* root = JSON_ReleaseTree(&parser.tree, retval != 0);
+
+  if (JSON_unlikely(retval != 0))
+    *type = NULL;
+  else if (root)
+    *type = root;
+
+  return retval;
+}
+
+
+
+
+void JSON_SetParserEngine(JSON_ParserEngine engine)
+{
+  default_engine = engine;
+}
+
+
+
+
+JSON_ParserEngine JSON_GetParserEngine(void)
+{
+  return default_engine;
+}
+
+
+
+
+int JSON_EngineParse(struct JSON_Type** type,
+                     JSON_Reader* reader,
+                     JSON_Hash hashFunc,
+                     size_t dictSize,
+                     size_t listSize,
+                     const JSON_Allocator* alloc,
+                     JSON_InternTable* keys)
+{
+  if (default_engine == JSON_PARSER_DESCENT)
+    return JSON_DescentParse(type, reader, hashFunc, dictSize, listSize, alloc, keys);
+
+  JSON_Type* old    = *type;
+  int        retval = JSON_yyparse(type, reader, hashFunc, dictSize, listSize,
+                                   alloc, keys);
+
+  /*  Bison keeps the tree it reduced before trailing input  */
+  if (JSON_unlikely(retval != 0))
+  {
+    if (*type != old)
+      JSON_FreeTypeWith(alloc, *type);
+
+    *type = NULL;
+  }
+
+  return retval;
+}
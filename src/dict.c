@@ -24,147 +24,625 @@
 /*=============================================================================+
  |                                  Includes                                   |
  +=============================================================================*/
+#include <stdint.h>
 #include <string.h>
 
+#include "allocator.h"
+#include "commons.h"
 #include "error.h"
+#include "hash.h"
 #include "json.h"
 
+#if defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** Fibonacci hashing constant, 2^64 / golden ratio. */
+#define FIBONACCI 0x9E3779B97F4A7C15ULL
+
+/** The bucket of a hash, from its high bits once mixed. */
+#define BUCKET(DICT,HASH) \
+  ((size_t)(((uint64_t)(HASH) * FIBONACCI) >> (DICT)->shift))
+
+#define GROUP        16   /**< Control bytes probed at once */
+#define CTRL_EMPTY   0x80 /**< Slot never used since the last rehash */
+#define CTRL_DELETED 0xFE /**< Slot of a removed entry */
+
+/** No slot, returned by find_slot(). */
+#define NO_SLOT SIZE_MAX
+
+/** No entry, ends the chains of the index. */
+#define NO_ENTRY UINT32_MAX
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+static JSON_DictEngine default_engine = JSON_DICT_CHAINED;
+
 
 
 
 /*=============================================================================+
  |                          Function Implementations                           |
  +=============================================================================*/
-JSON_Dict* JSON_MallocDict(size_t size, JSON_HashFunc hash)
+/**
+ * @brief Hash a key with the hash function of a dict.
+ *
+ * The default hash is called directly; only custom ones go through
+ * the pointer.
+ */
+static inline size_t hash_key(const JSON_Dict* dict, JSON_HashKey key)
 {
-  if (size == 0)
+  if (JSON_likely(dict->hash == JSON_DefaultHash))
+    return JSON_HashBytes(key, strlen(key));
+
+  return dict->hash(key);
+}
+
+
+
+
+/**
+ * @brief Check the key of an entry.
+ *
+ * Interned labels are the same pointer. Otherwise, the full hashes
+ * are compared first, so labels are only compared when they very
+ * likely match.
+ */
+static inline int same_key(const JSON_Type* entry, JSON_HashKey key, size_t hash)
+{
+  return entry->label == key || (entry->hash == hash && strcmp(entry->label, key) == 0);
+}
+
+
+
+
+/**
+ * @brief Find the control bytes of a group equal to a byte.
+ *
+ * @return A mask with the bit @b i set if the byte @b i matches.
+ */
+static inline uint32_t match_group(const uint8_t* group, uint8_t byte)
+{
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#else
+  uint32_t mask = 0;
+
+  for (int i=0; i < GROUP; ++i)
+    mask |= (uint32_t)(group[i] == byte) << i;
+
+  return mask;
+#endif
+}
+
+
+
+
+/**
+ * @brief Find the empty or deleted slots of a group.
+ *
+ * @return A mask with the bit @b i set if the slot @b i is free.
+ */
+static inline uint32_t match_free(const uint8_t* group)
+{
+#if defined(__SSE2__)
+  /*  Only free slots have their high bit set  */
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+  uint32_t mask = 0;
+
+  for (int i=0; i < GROUP; ++i)
+    mask |= (uint32_t)(group[i] >> 7) << i;
+
+  return mask;
+#endif
+}
+
+
+
+
+/**
+ * @brief Find the slot of a key in an open addressing dict.
+ *
+ * Groups are visited in triangular order, which covers all of them
+ * since their number is a power of two. The top 7 bits of the mixed
+ * hash are stored in the control byte of the slot, so the label is
+ * only compared when they match.
+ *
+ * @return The slot, or NO_SLOT.
+ */
+static size_t find_slot(const JSON_Dict* dict, JSON_HashKey key, uint64_t hash)
+{
+  uint64_t m    = hash * FIBONACCI;
+  uint8_t  h2   = m >> 57;
+  size_t   mask = dict->size / GROUP - 1;
+  size_t   g    = (m >> dict->shift) & mask;
+
+  for (size_t step=1; ; ++step)
   {
-    __JSON_SetError(JSON_EDICT_SIZE_EQZ);
-    return NULL;
+    const uint8_t* group = dict->ctrl + g * GROUP;
+
+    for (uint32_t bits = match_group(group, h2); bits; bits &= bits - 1)
+    {
+      size_t slot = g * GROUP + __builtin_ctz(bits);
+
+      if (JSON_likely(same_key(dict->entries[dict->index[slot]], key, hash)))
+        return slot;
+    }
+
+    if (JSON_likely(match_group(group, CTRL_EMPTY)))
+      return NO_SLOT;
+
+    g = (g + step) & mask;
+  }
+}
+
+
+
+
+/**
+ * @brief Find the first free slot for a hash in an open addressing
+ * dict, and point it to an entry.
+ */
+static void put_slot(JSON_Dict* dict, uint32_t i, uint64_t hash)
+{
+  uint64_t m    = hash * FIBONACCI;
+  size_t   mask = dict->size / GROUP - 1;
+  size_t   g    = (m >> dict->shift) & mask;
+  uint32_t bits;
+
+  for (size_t step=1; (bits = match_free(dict->ctrl + g * GROUP)) == 0; ++step)
+    g = (g + step) & mask;
+
+  size_t slot = g * GROUP + __builtin_ctz(bits);
+
+  if (dict->ctrl[slot] == CTRL_EMPTY)
+    --dict->growth;
+
+  dict->ctrl[slot]  = m >> 57;
+  dict->index[slot] = i;
+}
+
+
+
+
+/**
+ * @brief Find the position of a key in the entries of a dict.
+ *
+ * @return The position, or NO_ENTRY.
+ */
+static uint32_t find_entry(const JSON_Dict* dict, JSON_HashKey key, size_t hash)
+{
+  if (dict->flat)
+  {
+    for (size_t i=0; i < dict->used; ++i)
+    {
+      if (same_key(dict->entries[i], key, hash))
+        return i;
+    }
+
+    return NO_ENTRY;
   }
 
-  if (hash == NULL)
+  if (dict->engine == JSON_DICT_OPEN)
   {
-    __JSON_SetError(JSON_EDICT_NHASH_FUNC);
-    return NULL;
+    size_t slot = find_slot(dict, key, hash);
+
+    return slot == NO_SLOT ? NO_ENTRY : dict->index[slot];
   }
 
-  JSON_Dict* dict = calloc(1, sizeof(JSON_Dict));
+  uint32_t i = dict->index[BUCKET(dict, hash)];
 
-  if (dict)
+  while (i != NO_ENTRY && !same_key(dict->entries[i], key, hash))
+    i = dict->links[i];
+
+  return i;
+}
+
+
+
+
+/**
+ * @brief Point the index of a dict to an entry.
+ */
+static void index_entry(JSON_Dict* dict, uint32_t i)
+{
+  uint64_t hash = dict->entries[i]->hash;
+
+  if (dict->engine == JSON_DICT_OPEN)
+  {
+    put_slot(dict, i, hash);
+  }
+  else
   {
-    dict->hash = hash;
-    dict->size = size;
+    size_t b = BUCKET(dict, hash);
 
-    dict->buckets = calloc(dict->size, sizeof(JSON_Type*));
+    dict->links[i] = dict->index[b];
+    dict->index[b] = i;
   }
+}
 
-  return dict;
+
+
+
+/**
+ * @brief Empty the index of a dict, then point it to every entry.
+ */
+static void fill_index(JSON_Dict* dict)
+{
+  if (dict->engine == JSON_DICT_OPEN)
+  {
+    memset(dict->ctrl, CTRL_EMPTY, dict->size);
+    dict->growth = dict->size - dict->size / 8;
+  }
+  else
+  {
+    memset(dict->index, 0xFF, dict->size * sizeof(uint32_t));
+  }
+
+  for (size_t i=0; i < dict->used; ++i)
+  {
+    if (dict->entries[i])
+      index_entry(dict, i);
+  }
 }
 
 
 
 
-void JSON_FreeDict(JSON_Dict* dict)
+/**
+ * @brief Replace the index of a dict by one large enough for a number
+ * of entries.
+ *
+ * A chained index is a power of two buckets, at most 3/4 full, each
+ * holding the first entry of a chain linked through @b links. An open
+ * index is a power of two groups of slots, at most 7/8 full.
+ *
+ * @param [in,out] dict The JSON_Dict to index.
+ *
+ * @param [in] count The number of entries to hold before growing.
+ *
+ * @return 0 on success, -1 on failure; the dict is left untouched.
+ */
+static int alloc_index(JSON_Dict* dict, size_t count)
 {
-  if (dict)
+  const JSON_Allocator* alloc = dict->alloc;
+
+  unsigned  bits  = 0;
+  size_t    size;
+  uint8_t*  ctrl  = NULL;
+  uint32_t* links = dict->links;
+
+  if (dict->engine == JSON_DICT_OPEN)
   {
-    if (dict->buckets)
+    while (((size_t)GROUP << bits) - ((size_t)GROUP << bits) / 8 < count)
+      ++bits;
+
+    size = (size_t)GROUP << bits;
+    ctrl = alloc->alloc(alloc->ctx, size);
+
+    if (JSON_unlikely(ctrl == NULL))
+      return -1;
+  }
+  else
+  {
+    while (((size_t)1 << bits) - ((size_t)1 << bits) / 4 < count
+           || ((size_t)1 << bits) < JSON_DICT_MIN_SIZE)
+      ++bits;
+
+    size = (size_t)1 << bits;
+
+    if (links == NULL)
+      links = alloc->alloc(alloc->ctx, dict->capacity * sizeof(uint32_t));
+
+    if (JSON_unlikely(links == NULL))
+      return -1;
+  }
+
+  uint32_t* index = alloc->alloc(alloc->ctx, size * sizeof(uint32_t));
+
+  if (JSON_unlikely(index == NULL))
+  {
+    alloc->free(alloc->ctx, ctrl);
+
+    if (links != dict->links)
+      alloc->free(alloc->ctx, links);
+
+    return -1;
+  }
+
+  alloc->free(alloc->ctx, dict->index);
+  alloc->free(alloc->ctx, dict->ctrl);
+
+  dict->index = index;
+  dict->ctrl  = ctrl;
+  dict->links = links;
+  dict->size  = size;
+  dict->shift = dict->engine == JSON_DICT_OPEN ? 57 - bits : 64 - bits;
+  dict->flat  = 0;
+
+  fill_index(dict);
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Make room for one more entry in a dict.
+ *
+ * When the entries are full, the holes left by removed entries are
+ * squeezed out if there's any, keeping the order; otherwise the array
+ * doubles. A flat dict gets an index past JSON_DICT_FLAT_MAX entries,
+ * and the index grows with the number of entries.
+ *
+ * @return 0 on success, -1 on failure; the dict is left untouched.
+ */
+static int reserve_entry(JSON_Dict* dict)
+{
+  const JSON_Allocator* alloc = dict->alloc;
+
+  if (dict->used == dict->capacity)
+  {
+    if (dict->count < dict->used)
     {
-      for (size_t i=0; i < dict->size; ++i)
+      size_t j = 0;
+
+      for (size_t i=0; i < dict->used; ++i)
       {
-        JSON_Type** headP = &dict->buckets[i];
-        JSON_Type*  head  = *headP;
-
-        while (head)
-        {
-          *headP = head->next;
-          JSON_FreeType(head);
-          head = *headP;
-        }
+        if (dict->entries[i])
+          dict->entries[j++] = dict->entries[i];
       }
 
-      free(dict->buckets);
+      dict->used = j;
+
+      if (!dict->flat)
+        fill_index(dict);
     }
 
-    free(dict);
+    if (dict->used > dict->capacity / 2)
+    {
+      size_t capacity = 2 * dict->capacity;
+
+      if (JSON_unlikely(capacity >= NO_ENTRY))
+        return -1;
+
+      JSON_Type** entries = alloc->realloc(alloc->ctx, dict->entries,
+                                           dict->capacity * sizeof(JSON_Type*),
+                                           capacity * sizeof(JSON_Type*));
+
+      if (JSON_unlikely(entries == NULL))
+        return -1;
+
+      dict->entries = entries;
+
+      if (dict->links)
+      {
+        uint32_t* links = alloc->realloc(alloc->ctx, dict->links,
+                                         dict->capacity * sizeof(uint32_t),
+                                         capacity * sizeof(uint32_t));
+
+        if (JSON_unlikely(links == NULL))
+          return -1;
+
+        dict->links = links;
+      }
+
+      dict->capacity = capacity;
+    }
   }
+
+  if (dict->flat)
+  {
+    if (JSON_likely(dict->used < JSON_DICT_FLAT_MAX))
+      return 0;
+
+    return alloc_index(dict, 2 * (dict->count + 1));
+  }
+
+  if (dict->engine == JSON_DICT_OPEN)
+  {
+    /*  Keep one empty slot at least, or lookups wouldn't end  */
+    if (JSON_unlikely(dict->growth == 0))
+      return alloc_index(dict, 2 * (dict->count + 1));
+  }
+  else if (JSON_unlikely(dict->count + 1 > dict->size - dict->size / 4))
+  {
+    return alloc_index(dict, 2 * (dict->count + 1));
+  }
+
+  return 0;
 }
 
 
 
 
-const JSON_Type* JSON_GetDictValue(const char* key,
-                                   const JSON_Dict* dict)
+void JSON_SetDictEngine(JSON_DictEngine engine)
 {
-  size_t i       = dict->hash(key) % dict->size;
-  JSON_Type* ptr = dict->buckets[i];
+  default_engine = engine;
+}
 
-  while (ptr)
-  {
-    if (strcmp(ptr->label, key) == 0)
-      break;
 
-    ptr = ptr->next;
-  }
 
-  return ptr;
+
+JSON_Dict* JSON_MallocDict(size_t size, JSON_HashFunc hash)
+{
+  return JSON_MallocDictEngine(NULL, size, hash, default_engine);
 }
 
 
 
 
-JSON_Type* JSON_SetDictValue(JSON_Dict* dict, JSON_Type* value)
+JSON_Dict* JSON_MallocDictWith(const JSON_Allocator* alloc, size_t size, JSON_HashFunc hash)
 {
-  size_t i = dict->hash(value->label) % dict->size;
+  return JSON_MallocDictEngine(alloc, size, hash, default_engine);
+}
+
 
-  JSON_Type** headP = &(dict->buckets[i]);
-  JSON_Type*  head  = *headP;
 
-  while (head)
+
+JSON_Dict* JSON_MallocDictEngine(const JSON_Allocator* alloc,
+                                 size_t size,
+                                 JSON_HashFunc hash,
+                                 JSON_DictEngine engine)
+{
+  if (size == 0)
   {
-    if (strcmp(head->label, value->label) == 0)
-    {
-      value->next = head->next;
-      *headP      = value;
+    __JSON_SetError(JSON_EDICT_SIZE_EQZ);
+    return NULL;
+  }
+
+  if (hash == NULL)
+    hash = JSON_DefaultHash;
 
-      break;
+  if (alloc == NULL)
+    alloc = &JSON_DefaultAllocator;
+
+  JSON_Dict* dict = JSON_AllocZero(alloc, sizeof(JSON_Dict));
+
+  if (dict)
+  {
+    size_t capacity = 2;
+
+    while (capacity < size)
+      capacity *= 2;
+
+    dict->hash     = hash;
+    dict->alloc    = alloc;
+    dict->engine   = engine;
+    dict->flat     = 1;
+    dict->capacity = capacity;
+    dict->entries  = alloc->alloc(alloc->ctx, capacity * sizeof(JSON_Type*));
+
+    if (JSON_unlikely(dict->entries == NULL)
+        || (size > JSON_DICT_FLAT_MAX && alloc_index(dict, size) != 0))
+    {
+      JSON_FreeDict(dict);
+      return NULL;
     }
+  }
 
-    headP = &(head->next);
-    head  = *headP;
+  return dict;
+}
+
+
+
+
+void JSON_FreeDict(JSON_Dict* dict)
+{
+  if (dict)
+  {
+    for (size_t i=0; i < dict->used; ++i)
+      JSON_FreeTypeWith(dict->alloc, dict->entries[i]);
+
+    dict->alloc->free(dict->alloc->ctx, dict->entries);
+    dict->alloc->free(dict->alloc->ctx, dict->index);
+    dict->alloc->free(dict->alloc->ctx, dict->links);
+    dict->alloc->free(dict->alloc->ctx, dict->ctrl);
+    dict->alloc->free(dict->alloc->ctx, dict);
   }
+}
 
-  *headP = value;
 
-  return head;
+
+
+JSON_Type* JSON_NextDictValue(const JSON_Dict* dict, size_t* i)
+{
+  for (; *i < dict->used; ++*i)
+  {
+    if (dict->entries[*i])
+      return dict->entries[(*i)++];
+  }
+
+  return NULL;
 }
 
 
 
 
-int JSON_FreeDictValue(JSON_HashKey key, JSON_Dict* dict)
+const JSON_Type* JSON_GetDictValue(const char* key,
+                                   const JSON_Dict* dict)
+{
+  uint32_t i = find_entry(dict, key, hash_key(dict, key));
+
+  return i == NO_ENTRY ? NULL : dict->entries[i];
+}
+
+
+
+
+JSON_Type* JSON_SetDictValue(JSON_Dict* dict, JSON_Type* value)
 {
-  size_t i = dict->hash(key) % dict->size;
+  size_t length = strlen(value->label);
+
+  value->hash   = JSON_likely(dict->hash == JSON_DefaultHash)
+                  ? JSON_HashBytes(value->label, length)
+                  : dict->hash(value->label);
+  value->length = length;
+
+  return JSON_SetDictHashedValue(dict, value);
+}
+
 
-  JSON_Type** headP = &(dict->buckets[i]);
-  JSON_Type*  head  = *headP;
 
-  while (head)
+
+JSON_Type* JSON_SetDictHashedValue(JSON_Dict* dict, JSON_Type* value)
+{
+  uint32_t i = find_entry(dict, value->label, value->hash);
+
+  /*  A new value for a key keeps the position of the old one  */
+  if (i != NO_ENTRY)
   {
-    if (strcmp(head->label, key))
-    {
-      *headP = head->next;
-      JSON_FreeType(head);
+    JSON_Type* old = dict->entries[i];
 
-      return 0;
-    }
+    dict->entries[i] = value;
 
-    headP = &head->next;
-    head  = *headP;
+    return old;
+  }
+
+  if (JSON_unlikely(reserve_entry(dict) != 0))
+  {
+    __JSON_SetError(JSON_EDICT_FAILED_REHASH);
+    return value;
   }
 
-  return -1;
+  i = dict->used++;
+
+  dict->entries[i] = value;
+  ++dict->count;
+
+  if (!dict->flat)
+    index_entry(dict, i);
+
+  return NULL;
+}
+
+
+
+
+int JSON_FreeDictValue(JSON_HashKey key, JSON_Dict* dict)
+{
+  JSON_Type* head = JSON_DelDictValue(key, dict);
+
+  if (head == NULL)
+    return -1;
+
+  JSON_FreeTypeWith(dict->alloc, head);
+
+  return 0;
 }
 
 
@@ -172,23 +650,68 @@ int JSON_FreeDictValue(JSON_HashKey key, JSON_Dict* dict)
 
 JSON_Type* JSON_DelDictValue(JSON_HashKey key, JSON_Dict* dict)
 {
-  size_t i = dict->hash(key) % dict->size;
+  size_t   hash = hash_key(dict, key);
+  uint32_t i;
 
-  JSON_Type** headP = &dict->buckets[i];
-  JSON_Type*  head  = *headP;
+  if (dict->flat)
+  {
+    i = find_entry(dict, key, hash);
 
-  while (head)
+    if (i == NO_ENTRY)
+      return NULL;
+
+    JSON_Type* head = dict->entries[i];
+
+    /*  No index to update, close the gap right away  */
+    memmove(dict->entries + i, dict->entries + i + 1,
+            (dict->used - i - 1) * sizeof(JSON_Type*));
+
+    --dict->used;
+    --dict->count;
+
+    return head;
+  }
+
+  if (dict->engine == JSON_DICT_OPEN)
   {
-    if (strcmp(head->label, key) == 0 )
-    {
-      *headP = head->next;
+    size_t slot = find_slot(dict, key, hash);
 
-      break;
+    if (slot == NO_SLOT)
+      return NULL;
+
+    /*  If the group was never full, no probe went past it and the slot
+     *  can be empty again  */
+    if (match_group(dict->ctrl + slot / GROUP * GROUP, CTRL_EMPTY))
+    {
+      dict->ctrl[slot] = CTRL_EMPTY;
+      ++dict->growth;
+    }
+    else
+    {
+      dict->ctrl[slot] = CTRL_DELETED;
     }
 
-    headP = &head->next;
-    head  = *headP;
+    i = dict->index[slot];
   }
+  else
+  {
+    uint32_t* link = &dict->index[BUCKET(dict, hash)];
+
+    while (*link != NO_ENTRY && !same_key(dict->entries[*link], key, hash))
+      link = &dict->links[*link];
+
+    if (*link == NO_ENTRY)
+      return NULL;
+
+    i     = *link;
+    *link = dict->links[i];
+  }
+
+  JSON_Type* head = dict->entries[i];
+
+  /*  Leave a hole, squeezed out when the entries are full  */
+  dict->entries[i] = NULL;
+  --dict->count;
 
   return head;
 }
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file document.c
+ *
+ * @brief JSON_Document structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include "commons.h"
+#include "document.h"
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+JSON_Document* JSON_MallocDocument(void)
+{
+  JSON_Document* document = calloc(1, sizeof(JSON_Document));
+
+  if (JSON_likely(document != NULL))
+  {
+    document->arena = JSON_MallocArena(0);
+    document->keys  = JSON_MallocInternTable();
+
+    if (JSON_unlikely(document->arena == NULL || document->keys == NULL))
+    {
+      JSON_FreeDocument(document);
+      return NULL;
+    }
+
+    JSON_InitArenaAllocator(&document->alloc, document->arena);
+  }
+
+  return document;
+}
+
+
+
+
+void JSON_FreeDocument(JSON_Document* document)
+{
+  if (document)
+  {
+    JSON_FreeArena(document->arena);
+    JSON_FreeInternTable(document->keys);
+    free(document);
+  }
+}
+
+
+
+
+void JSON_ResetDocument(JSON_Document* document)
+{
+  JSON_ResetArena(document->arena);
+  JSON_ResetInternTable(document->keys);
+
+  document->root = NULL;
+}
@@ -39,9 +39,10 @@
 /*=============================================================================+
  |                              Global Variables                               |
  +=============================================================================*/
-static char user_buffer[JSON_MAX_USER_BUFF];
+/*  Every thread has its own error  */
+static _Thread_local char user_buffer[JSON_MAX_USER_BUFF];
 
-static const JSON_Error* current = NULL;
+static _Thread_local const JSON_Error* current = NULL;
 
 static const JSON_Error errors[JSON_ETOTAL+1] =
 {
@@ -51,7 +52,8 @@ static const JSON_Error errors[JSON_ETOTAL+1] =
   {JSON_EDICT_SIZE_EQZ,       "Size of dict hash table is equal to 0.\n"},
   {JSON_ELIST_SIZE_EQZ,       "Size of list vector is equal to 0.\n"},
   {JSON_ELIST_BAD_INDEX,      "Index of list is too large.\n"},
-  {JSON_EUSER,                user_buffer},
+  {JSON_EUSER,                NULL}, /*  In user_buffer  */
+  {JSON_EDICT_FAILED_REHASH,  "JSON_Dict failed to grow its hash table.\n"},
   {JSON_ETOTAL,               NULL}
 };
 
@@ -70,6 +72,9 @@ void JSON_ClearError(void)
 
 const char* JSON_GetError(void)
 {
+  if (JSON_unlikely(current == &errors[JSON_EUSER]))
+    return user_buffer;
+
   if (JSON_likely(current != NULL))
     return current->message;
 
@@ -97,7 +102,7 @@ int JSON_SetError(const char* format, ...)
 
   va_start (args, format);
 
-  code = vsprintf(user_buffer, format, args);
+  code = vsnprintf(user_buffer, sizeof(user_buffer), format, args);
 
   if (code > 0)
     current = &errors[JSON_EUSER];
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file hash.c
+ *
+ * @brief Default hash function implementation.
+ *
+ * The mixing follows wyhash (final version 4, public domain): keys of
+ * at most 16 bytes are read as two overlapping words, longer keys are
+ * consumed 16 or 48 bytes at a time. The seed is mixed with the
+ * secret when it's set, not at every call.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/random.h>
+
+#include "commons.h"
+#include "hash.h"
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+/** Odd constants with 32 bits set, from wyhash. */
+static const uint64_t secret[4] =
+{
+  0x2d358dccaa6c78a5ULL,
+  0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL,
+  0x4d5a2da51de1aa47ULL
+};
+
+/** The seed, already mixed with the secret. */
+static uint64_t seed = 0x2d358dccaa6c78a5ULL;
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Full 64 bits by 64 bits multiplication.
+ */
+static inline void multiply(uint64_t* a, uint64_t* b)
+{
+  unsigned __int128 r = (unsigned __int128)*a * *b;
+
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+}
+
+
+
+
+/**
+ * @brief Multiply, then fold the high bits on the low ones.
+ */
+static inline uint64_t mix(uint64_t a, uint64_t b)
+{
+  multiply(&a, &b);
+
+  return a ^ b;
+}
+
+
+
+
+static inline uint64_t read8(const uint8_t* p)
+{
+  uint64_t v;
+
+  memcpy(&v, p, sizeof(v));
+
+  return v;
+}
+
+
+
+
+static inline uint64_t read4(const uint8_t* p)
+{
+  uint32_t v;
+
+  memcpy(&v, p, sizeof(v));
+
+  return v;
+}
+
+
+
+
+/**
+ * @brief Draw the seed of the process, before main().
+ *
+ * If the kernel has no entropy to give, the time and the address of
+ * the stack are good enough to not be guessed from the input.
+ */
+__attribute__((constructor))
+static void init_seed(void)
+{
+  uint64_t x;
+
+  if (getrandom(&x, sizeof(x), GRND_NONBLOCK) != sizeof(x))
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    x = mix((uint64_t)ts.tv_nsec ^ (uint64_t)(uintptr_t)&ts,
+            (uint64_t)ts.tv_sec  ^ (uint64_t)getpid());
+  }
+
+  JSON_SetHashSeed(x);
+}
+
+
+
+
+void JSON_SetHashSeed(uint64_t x)
+{
+  seed = x ^ mix(x ^ secret[0], secret[1]);
+}
+
+
+
+
+uint64_t JSON_HashBytes(const void* data, size_t len)
+{
+  const uint8_t* p = data;
+  uint64_t       s = seed;
+  uint64_t       a;
+  uint64_t       b;
+
+  if (JSON_likely(len <= 16))
+  {
+    if (JSON_likely(len >= 4))
+    {
+      a = (read4(p) << 32) | read4(p + ((len >> 3) << 2));
+      b = (read4(p + len - 4) << 32) | read4(p + len - 4 - ((len >> 3) << 2));
+    }
+    else if (len > 0)
+    {
+      a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+      b = 0;
+    }
+    else
+    {
+      a = b = 0;
+    }
+  }
+  else
+  {
+    size_t i = len;
+
+    if (JSON_unlikely(i > 48))
+    {
+      uint64_t s1 = s;
+      uint64_t s2 = s;
+
+      do
+      {
+        s  = mix(read8(p)      ^ secret[1], read8(p + 8)  ^ s);
+        s1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ s1);
+        s2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ s2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+
+      s ^= s1 ^ s2;
+    }
+
+    while (i > 16)
+    {
+      s  = mix(read8(p) ^ secret[1], read8(p + 8) ^ s);
+      p += 16;
+      i -= 16;
+    }
+
+    a = read8(p + i - 16);
+    b = read8(p + i - 8);
+  }
+
+  a ^= secret[1];
+  b ^= s;
+
+  multiply(&a, &b);
+
+  return mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+
+
+
+size_t JSON_DefaultHash(JSON_HashKey key)
+{
+  return JSON_HashBytes(key, strlen(key));
+}
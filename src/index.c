@@ -0,0 +1,481 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file index.c
+ *
+ * @brief JSON_Index structure implementations.
+ *
+ * The buffer is processed by blocks of 64 bytes. A kernel classifies
+ * every byte of a block in 4 bit masks: quotes, backslashes,
+ * operators and white spaces. The rest is done on the masks with
+ * plain 64 bits arithmetic, the same way for every kernel:
+ *
+ * - Quotes escaped by an odd sequence of backslashes are removed.
+ * - The prefix xor of the quotes gives the in-string region.
+ * - Token starts are the operators and the first character of every
+ *   scalar, outside of the strings.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdint.h>
+#include <string.h>
+
+#include "commons.h"
+#include "index.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#  define JSON_X86 1
+#  include <immintrin.h>
+#endif
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+#define QUOTE     0x01
+#define BACKSLASH 0x02
+#define OPERATOR  0x04
+#define SPACE     0x08
+
+#define EVEN_BITS 0x5555555555555555ULL
+#define ODD_BITS  (~EVEN_BITS)
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/** Classification of a block of 64 bytes, one bit per byte. */
+typedef struct Masks
+{
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t op;
+  uint64_t ws;
+} Masks;
+
+
+
+
+/** What is carried from a block to the next one. */
+typedef struct State
+{
+  uint64_t odd_backslash; /**< 1 if the previous block ended with an odd
+                           * sequence of backslashes. */
+  uint64_t in_string;     /**< All ones if the previous block ended in a
+                           * string. */
+  uint64_t scalar;        /**< 1 if the previous block ended with a
+                           * scalar character. */
+} State;
+
+
+
+
+/** A classification kernel. */
+typedef struct Kernel
+{
+  const char* name;
+  void (*classify)(const unsigned char* block, Masks* masks);
+} Kernel;
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+static const unsigned char classes[256] =
+{
+  ['"']  = QUOTE,
+  ['\\'] = BACKSLASH,
+  ['{']  = OPERATOR,
+  ['}']  = OPERATOR,
+  ['[']  = OPERATOR,
+  [']']  = OPERATOR,
+  [':']  = OPERATOR,
+  [',']  = OPERATOR,
+  [' ']  = SPACE,
+  ['\t'] = SPACE,
+  ['\n'] = SPACE,
+  ['\r'] = SPACE,
+};
+
+
+
+
+/*=============================================================================+
+ |                                   Kernels                                   |
+ +=============================================================================*/
+static void classify_scalar(const unsigned char* block, Masks* masks)
+{
+  uint64_t m[4] = {0, 0, 0, 0};
+
+  for (int i=0; i < 64; ++i)
+  {
+    unsigned char c = classes[block[i]];
+
+    m[0] |= (uint64_t)((c & QUOTE)     != 0) << i;
+    m[1] |= (uint64_t)((c & BACKSLASH) != 0) << i;
+    m[2] |= (uint64_t)((c & OPERATOR)  != 0) << i;
+    m[3] |= (uint64_t)((c & SPACE)     != 0) << i;
+  }
+
+  masks->quote     = m[0];
+  masks->backslash = m[1];
+  masks->op        = m[2];
+  masks->ws        = m[3];
+}
+
+
+
+
+#ifdef JSON_X86
+__attribute__((target("sse4.2")))
+static void classify_sse42(const unsigned char* block, Masks* masks)
+{
+  const __m128i ops    = _mm_setr_epi8('{', '}', '[', ']', ':', ',',
+                                       0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i spaces = _mm_setr_epi8(' ', '\t', '\n', '\r',
+                                       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i quote     = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+
+  const int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+
+  Masks m = {0, 0, 0, 0};
+
+  for (int i=0; i < 4; ++i)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+
+    uint64_t q = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote));
+    uint64_t b = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash));
+    uint64_t o = (uint16_t)_mm_cvtsi128_si32(_mm_cmpestrm(ops, 6, v, 16, mode));
+    uint64_t w = (uint16_t)_mm_cvtsi128_si32(_mm_cmpestrm(spaces, 4, v, 16, mode));
+
+    m.quote     |= q << (16 * i);
+    m.backslash |= b << (16 * i);
+    m.op        |= o << (16 * i);
+    m.ws        |= w << (16 * i);
+  }
+
+  *masks = m;
+}
+
+
+
+
+__attribute__((target("avx2")))
+static void classify_avx2(const unsigned char* block, Masks* masks)
+{
+#define EQ(V, C) _mm256_cmpeq_epi8(V, _mm256_set1_epi8(C))
+#define BITS(X)  ((uint64_t)(uint32_t)_mm256_movemask_epi8(X))
+
+  Masks m = {0, 0, 0, 0};
+
+  for (int i=0; i < 2; ++i)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(block + 32 * i));
+
+    __m256i op = _mm256_or_si256(_mm256_or_si256(EQ(v, '{'), EQ(v, '}')),
+                                 _mm256_or_si256(EQ(v, '['), EQ(v, ']')));
+    op = _mm256_or_si256(op, _mm256_or_si256(EQ(v, ':'), EQ(v, ',')));
+
+    __m256i ws = _mm256_or_si256(_mm256_or_si256(EQ(v, ' '), EQ(v, '\t')),
+                                 _mm256_or_si256(EQ(v, '\n'), EQ(v, '\r')));
+
+    m.quote     |= BITS(EQ(v, '"'))  << (32 * i);
+    m.backslash |= BITS(EQ(v, '\\')) << (32 * i);
+    m.op        |= BITS(op)          << (32 * i);
+    m.ws        |= BITS(ws)          << (32 * i);
+  }
+
+  *masks = m;
+
+#undef EQ
+#undef BITS
+}
+#endif // JSON_X86
+
+
+
+
+static const Kernel scalar = {"scalar", classify_scalar};
+#ifdef JSON_X86
+static const Kernel sse42  = {"sse4.2", classify_sse42};
+static const Kernel avx2   = {"avx2",   classify_avx2};
+#endif
+
+/** The best kernel supported by the CPU, selected before main(). */
+static const Kernel* best = &scalar;
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Select the best kernel supported by the CPU, before main(), so
+ * the indexing threads don't race to select it.
+ */
+__attribute__((constructor))
+static void init_kernel(void)
+{
+#ifdef JSON_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    best = &avx2;
+  else if (__builtin_cpu_supports("sse4.2"))
+    best = &sse42;
+#endif
+}
+
+
+
+
+/**
+ * @brief Find the characters escaped by an odd sequence of backslashes.
+ *
+ * @param [in] backslash The backslashes of the block.
+ *
+ * @param [in,out] state The carried state.
+ *
+ * @return The mask of escaped characters.
+ */
+static uint64_t find_escaped(uint64_t backslash, State* state)
+{
+  uint64_t start_edges     = backslash & ~(backslash << 1);
+  uint64_t even_start_mask = EVEN_BITS ^ state->odd_backslash;
+  uint64_t even_starts     = start_edges & even_start_mask;
+  uint64_t odd_starts      = start_edges & ~even_start_mask;
+  uint64_t even_carries    = backslash + even_starts;
+  uint64_t odd_carries;
+
+  int ends_odd = __builtin_add_overflow(backslash, odd_starts, &odd_carries);
+
+  /*  An odd sequence at the end of the last block escape the first bit  */
+  odd_carries |= state->odd_backslash;
+  state->odd_backslash = ends_odd ? 1 : 0;
+
+  uint64_t even_carry_ends = even_carries & ~backslash;
+  uint64_t odd_carry_ends  = odd_carries & ~backslash;
+
+  return (even_carry_ends & ODD_BITS) | (odd_carry_ends & EVEN_BITS);
+}
+
+
+
+
+/**
+ * @brief Compute the prefix xor of a mask.
+ *
+ * Every bit is the xor of itself and all the bits before it.
+ */
+static uint64_t prefix_xor(uint64_t x)
+{
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+
+  return x;
+}
+
+
+
+
+/**
+ * @brief Find the token starts of a classified block.
+ *
+ * @param [in] m The classification of the block.
+ *
+ * @param [in,out] state The carried state.
+ *
+ * @return The mask of token starts.
+ */
+static uint64_t find_starts(const Masks* m, State* state)
+{
+  uint64_t quote     = m->quote & ~find_escaped(m->backslash, state);
+  uint64_t in_string = prefix_xor(quote) ^ state->in_string;
+
+  state->in_string = (uint64_t)((int64_t)in_string >> 63);
+
+  /*  In string, including the closing quote but not the opening one  */
+  uint64_t tail = in_string ^ quote;
+
+  uint64_t scalar  = ~(m->op | m->ws);
+  uint64_t bare    = scalar & ~quote;
+  uint64_t follows = (bare << 1) | state->scalar;
+
+  state->scalar = bare >> 63;
+
+  return (m->op | (scalar & ~follows)) & ~tail;
+}
+
+
+
+
+/**
+ * @brief Find a kernel by name, if the CPU supports it.
+ *
+ * @return The kernel, or @b NULL.
+ */
+static const Kernel* find_kernel(const char* name)
+{
+  if (strcmp(name, scalar.name) == 0)
+    return &scalar;
+
+#ifdef JSON_X86
+  __builtin_cpu_init();
+
+  if (strcmp(name, avx2.name) == 0 && __builtin_cpu_supports("avx2"))
+    return &avx2;
+
+  if (strcmp(name, sse42.name) == 0 && __builtin_cpu_supports("sse4.2"))
+    return &sse42;
+#endif
+
+  return NULL;
+}
+
+
+
+
+JSON_Index* JSON_MallocIndex(const char* buf, size_t len)
+{
+  return JSON_MallocIndexKernel(buf, len, NULL);
+}
+
+
+
+
+JSON_Index* JSON_MallocIndexKernel(const char* buf, size_t len, const char* name)
+{
+  const Kernel* kernel = name ? find_kernel(name) : best;
+
+  if (JSON_unlikely(kernel == NULL || len > UINT32_MAX))
+    return NULL;
+
+  JSON_Index* index = calloc(1, sizeof(JSON_Index));
+
+  if (JSON_unlikely(index == NULL))
+    return NULL;
+
+  /*  Roughly one token every 8 bytes, grows if needed  */
+  index->size      = len / 8 + 64;
+  index->positions = malloc(index->size * sizeof(uint32_t));
+
+  if (JSON_unlikely(index->positions == NULL))
+  {
+    free(index);
+    return NULL;
+  }
+
+  State state = {0, 0, 0};
+  Masks masks;
+
+  unsigned char tail[64];
+
+  for (size_t offset=0; offset < len; offset += 64)
+  {
+    const unsigned char* block = (const unsigned char*)buf + offset;
+
+    /*  The last block is padded with white spaces  */
+    if (len - offset < 64)
+    {
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, block, len - offset);
+      block = tail;
+    }
+
+    kernel->classify(block, &masks);
+
+    uint64_t starts = find_starts(&masks, &state);
+
+    if (JSON_unlikely(index->count + 64 > index->size))
+    {
+      size_t    size      = index->size * 2;
+      uint32_t* positions = realloc(index->positions, size * sizeof(uint32_t));
+
+      if (JSON_unlikely(positions == NULL))
+      {
+        JSON_FreeIndex(index);
+        return NULL;
+      }
+
+      index->positions = positions;
+      index->size      = size;
+    }
+
+    uint32_t* p = index->positions + index->count;
+
+    while (starts)
+    {
+      *p++ = offset + __builtin_ctzll(starts);
+      starts &= starts - 1;
+    }
+
+    index->count = p - index->positions;
+  }
+
+  return index;
+}
+
+
+
+
+void JSON_FreeIndex(JSON_Index* index)
+{
+  if (index)
+  {
+    free(index->positions);
+    free(index);
+  }
+}
+
+
+
+
+int JSON_IndexReader(JSON_Reader* reader, const JSON_Index* index)
+{
+  if (reader->fd != NULL)
+    return -1;
+
+  reader->base = reader->cursor;
+  reader->next = index->positions;
+  reader->last = index->positions + index->count;
+
+  return 0;
+}
+
+
+
+
+const char* JSON_GetIndexKernel(void)
+{
+  return best->name;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file intern.c
+ *
+ * @brief JSON_InternTable structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <string.h>
+
+#include "commons.h"
+#include "hash.h"
+#include "intern.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The number of slots of a new table. */
+#define INTERN_MIN_SIZE 64
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Double the number of slots of a table and move every string.
+ *
+ * @return 0 on success, -1 on failure; the table is left untouched.
+ */
+static int grow_table(JSON_InternTable* table)
+{
+  size_t    size  = table->size ? 2 * table->size : INTERN_MIN_SIZE;
+  JSON_Key* slots = calloc(size, sizeof(JSON_Key));
+
+  if (JSON_unlikely(slots == NULL))
+    return -1;
+
+  for (size_t i=0; i < table->size; ++i)
+  {
+    if (table->slots[i].str == NULL)
+      continue;
+
+    size_t j = table->slots[i].hash & (size - 1);
+
+    while (slots[j].str)
+      j = (j + 1) & (size - 1);
+
+    slots[j] = table->slots[i];
+  }
+
+  free(table->slots);
+
+  table->slots = slots;
+  table->size  = size;
+
+  return 0;
+}
+
+
+
+
+JSON_InternTable* JSON_MallocInternTable(void)
+{
+  return calloc(1, sizeof(JSON_InternTable));
+}
+
+
+
+
+void JSON_FreeInternTable(JSON_InternTable* table)
+{
+  if (table)
+  {
+    free(table->slots);
+    free(table);
+  }
+}
+
+
+
+
+void JSON_ResetInternTable(JSON_InternTable* table)
+{
+  if (table->count)
+    memset(table->slots, 0, table->size * sizeof(JSON_Key));
+
+  table->count = 0;
+}
+
+
+
+
+int JSON_InternString(JSON_InternTable* table, JSON_Key* key)
+{
+  key->hash = JSON_HashBytes(key->str, key->length);
+
+  /*  At most half full  */
+  if (JSON_unlikely(2 * (table->count + 1) > table->size) && grow_table(table) != 0)
+    return 0;
+
+  size_t mask = table->size - 1;
+  size_t i    = key->hash & mask;
+
+  for (; table->slots[i].str; i = (i + 1) & mask)
+  {
+    const JSON_Key* slot = table->slots + i;
+
+    if (slot->hash == key->hash && slot->length == key->length
+        && memcmp(slot->str, key->str, key->length) == 0)
+    {
+      key->str = slot->str;
+      return 1;
+    }
+  }
+
+  table->slots[i] = *key;
+  ++table->count;
+
+  return 0;
+}
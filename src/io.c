@@ -24,6 +24,9 @@
 /*=============================================================================+
  |                                  Includes                                   |
  +=============================================================================*/
+#include <stdint.h>
+#include <string.h>
+
 #include "io.h"
 
 
@@ -40,15 +43,68 @@
 /*=============================================================================+
  |                              Global Variables                               |
  +=============================================================================*/
-static size_t      nest_level = 0;
+static _Thread_local size_t nest_level = 0;
 static const char* bools[3]   = {"false", "null", "true"};
 
+/** Every pair of decimal digits, from "00" to "99". */
+static const char digit_pairs[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
 
 
 
 /*=============================================================================+
  |                          Function Implementations                           |
  +=============================================================================*/
+/**
+ * @brief Write an integer to file descriptor, two digits at a time.
+ *
+ * @param [in] x The absolute value of the integer.
+ *
+ * @param [in] negative Non zero if the integer is negative.
+ *
+ * @param [out] fd The file descriptor to write to.
+ */
+static void print_integer(uint64_t x, int negative, FILE* fd)
+{
+  char  buf[24];
+  char* p = buf + sizeof(buf);
+
+  while (x >= 100)
+  {
+    p -= 2;
+    memcpy(p, digit_pairs + 2 * (x % 100), 2);
+    x /= 100;
+  }
+
+  if (x >= 10)
+  {
+    p -= 2;
+    memcpy(p, digit_pairs + 2 * x, 2);
+  }
+  else
+  {
+    *--p = '0' + x;
+  }
+
+  if (negative)
+    *--p = '-';
+
+  fwrite(p, 1, buf + sizeof(buf) - p, fd);
+}
+
+
+
+
 void JSON_PrintType(const JSON_Type* type, FILE* fd)
 {
 
@@ -65,6 +121,13 @@ void JSON_PrintType(const JSON_Type* type, FILE* fd)
   case JSON_NUMBER:
     fprintf(fd, "%lf", type->num);
     break;
+  case JSON_INTEGER:
+    print_integer(type->integer < 0 ? 0 - (uint64_t)type->integer : (uint64_t)type->integer,
+                  type->integer < 0, fd);
+    break;
+  case JSON_UNSIGNED:
+    print_integer(type->uinteger, 0, fd);
+    break;
   case JSON_STRING:
     fprintf(fd, "\"%s\"", type->str);
     break;
@@ -108,16 +171,13 @@ void JSON_PrintDict(const JSON_Dict* dict, FILE* fd)
   PRINT_INDENT(fd);
   fprintf(fd, "{\n");
   ++nest_level;
-  for (size_t i=0; i<dict->size; ++i)
-  {
-    JSON_Type* head = dict->buckets[i];
+  size_t     i    = 0;
+  JSON_Type* head = NULL;
 
-    while (head)
-    {
-      JSON_PrintType(head, fd);
-      fprintf(fd, ",\n");
-      head = head->next;
-    }
+  while ((head = JSON_NextDictValue(dict, &i)) != NULL)
+  {
+    JSON_PrintType(head, fd);
+    fprintf(fd, ",\n");
   }
   // Change last ",\n" for "\n"
   fseek(fd, -2, SEEK_CUR);
@@ -29,8 +29,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "allocator.h"
 #include "commons.h"
+#include "number.h"
 #include "parser.h"
+#include "reader.h"
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#  include <immintrin.h>
+#endif
 
 
 
@@ -38,7 +45,35 @@
 /*=============================================================================+
  |                                   Macros                                    |
  +=============================================================================*/
-#define SKIP_WS(c, fd) while((c = fgetc(fd)) == ' ' || c == '\t')
+#define WS     0x01 /**< White space */
+#define NUMBER 0x02 /**< Part of a number */
+#define WORD   0x04 /**< Part of a word, i.e alphanumeric */
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+/** Class of every characters, as a mask of WS, NUMBER and WORD. */
+static const unsigned char classes[256] =
+{
+  [' ']         = WS,
+  ['\t']        = WS,
+  ['\r']        = WS,
+  ['\n']        = WS,
+  ['+']         = NUMBER,
+  ['-']         = NUMBER,
+  ['.']         = NUMBER,
+  ['0' ... '9'] = NUMBER | WORD,
+  ['A' ... 'D'] = WORD,
+  ['E']         = NUMBER | WORD,
+  ['F' ... 'Z'] = WORD,
+  ['a' ... 'd'] = WORD,
+  ['e']         = NUMBER | WORD,
+  ['f' ... 'z'] = WORD,
+};
+
 
 
 
@@ -46,171 +81,543 @@
  |                          Function Implementations                           |
  +=============================================================================*/
 /**
- * @brief Read a word from a stream.
+ * @brief Skip white spaces in a reader.
  *
- * @param [out] buf The buffer to fill.
+ * @param [in,out] reader The reader to skip white spaces from.
  *
- * @param [in] fd The stream to read from
+ * @param [out] loc_p Pointer to the location used by JSON_Parser
  *
- * @return The number of characters readed from stream.
+ * @return The next character in the reader, or @b EOF.
  */
-static ssize_t get_word(char** buf, FILE* fd)
+static int skip_ws(JSON_Reader* reader, JSON_YYLTYPE* loc_p)
 {
-  /*  Initial size of buffer is 255 */
-  size_t len = 0xFF;
-  ssize_t n  = 0;
-  char c;
+  for (;;)
+  {
+    const char* p = reader->cursor;
 
-  /*  Buffer allocaiton  */
-  *buf = calloc(len + 1, sizeof(char));
+    while (p < reader->limit && (classes[(unsigned char)*p] & WS))
+    {
+      if (*p++ == '\n')
+      {
+        ++(loc_p->last_line);
+        loc_p->last_column = 0;
+      }
+      else
+      {
+        ++(loc_p->last_column);
+      }
+    }
+
+    reader->cursor = p;
+
+    if (JSON_likely(p < reader->limit))
+      return (unsigned char)*p;
+
+    if (JSON_FillReader(reader) == 0)
+      return EOF;
+  }
+}
 
-  if (JSON_unlikely(*buf == NULL))
-    return 0;
 
-  /* While readed char is alnum, place it in the buffer  */
-  while (isalnum(c = fgetc(fd)))
-  {
-    /*  Resize the buffer if needed  */
-    if (n == len)
-    {
-      len *= 2;
-      *buf = realloc(*buf, len + 1);
 
-      if (JSON_unlikely(*buf == NULL))
-        return 0;
-    }
 
-    (*buf)[n++] = c;
+/**
+ * @brief Jump to the next token start in the index of a reader.
+ *
+ * @param [in,out] reader The indexed reader.
+ *
+ * @param [out] loc_p Pointer to the location used by JSON_Parser
+ *
+ * @return The next character in the reader, or @b EOF.
+ */
+static int skip_indexed(JSON_Reader* reader, JSON_YYLTYPE* loc_p)
+{
+  if (JSON_unlikely(reader->next == reader->last))
+  {
+    reader->cursor = reader->limit;
+    return EOF;
   }
 
-  /*  End of string  */
-  (*buf)[n] = '\0';
+  reader->cursor = reader->base + *reader->next++;
 
-  /*  Push back last readed char  */
-  ungetc(c, fd);
+  /*  Lines are not tracked, the column is the offset in the buffer  */
+  loc_p->last_column = reader->cursor - reader->base;
 
-  return n - 1;
+  return (unsigned char)*reader->cursor;
 }
 
 
 
 
 /**
- * @brief JSON Lexer.
- *
- * @param [out] val_p Pointer to the value used by JSON_parser
+ * @brief Check that only white spaces are left between the end of a
+ * scalar and the next token start in the index of a reader.
  *
- * @param [out] loc_p Pointer to the location used by JSON_Parser
+ * The index has no start in the characters that follow a scalar, so
+ * they are checked here, unlike the ones skipped by skip_ws().
  *
- * @param [in] fd File descriptor to read from
+ * @param [in] reader The indexed reader, after the scalar.
  *
- * @return Token type.
+ * @return Non zero if the scalar ends properly.
  */
-int JSON_lex(JSON_STYPE* val_p, JSON_LTYPE* loc_p, FILE* fd)
+static int ends_indexed(const JSON_Reader* reader)
 {
-  int c;
+  const char* next = reader->next < reader->last ? reader->base + *reader->next
+                                                 : reader->limit;
 
-  SKIP_WS(c, fd)
-    ++(loc_p->last_column);
+  for (const char* p = reader->cursor; p < next; ++p)
+  {
+    if (!(classes[(unsigned char)*p] & WS))
+      return 0;
+  }
 
-  loc_p->first_line = loc_p->last_line;
-  loc_p->first_column = loc_p->last_column;
+  return 1;
+}
 
-  if (c == EOF)
+
+
+
+/**
+ * @brief Read a span of characters of the same class.
+ *
+ * On return, the span is [reader->mark, reader->cursor). It's the
+ * responsability of the caller to reset the mark.
+ *
+ * @param [in,out] reader The reader to read from.
+ *
+ * @param [in] class The class of characters in the span.
+ *
+ * @return The length of the span.
+ */
+static size_t read_span(JSON_Reader* reader, unsigned char class)
+{
+  const char* p = reader->cursor;
+
+  reader->mark = p;
+
+  for (;;)
   {
-    if (ferror(fd))
-      perror("Lexer EOF");
+    while (p < reader->limit && (classes[(unsigned char)*p] & class))
+      ++p;
 
-    return 0;
+    if (JSON_likely(p < reader->limit))
+      break;
+
+    reader->cursor = p;
+
+    size_t n = JSON_FillReader(reader);
+
+    p = reader->cursor;
+
+    if (n == 0)
+      break;
   }
 
-  if (c == '\n')
+  reader->cursor = p;
+
+  return p - reader->mark;
+}
+
+
+
+
+/**
+ * @brief Find the first quote or backslash in a span.
+ *
+ * The span is scanned 32 or 16 bytes at a time when the target
+ * supports it.
+ *
+ * @param [in] p The start of the span.
+ *
+ * @param [in] limit One past the end of the span.
+ *
+ * @return A pointer to the first quote or backslash, or @b limit.
+ */
+static const char* find_special(const char* p, const char* limit)
+{
+#if defined(__AVX2__)
+  const __m256i quote32     = _mm256_set1_epi8('"');
+  const __m256i backslash32 = _mm256_set1_epi8('\\');
+
+  while (limit - p >= 32)
   {
-    ++(loc_p->last_line);
-    loc_p->last_column = 0;
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    __m256i x = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote32),
+                                _mm256_cmpeq_epi8(v, backslash32));
 
-    SKIP_WS(c, fd)
-      ++(loc_p->last_column);
+    unsigned int m = _mm256_movemask_epi8(x);
+
+    if (m)
+      return p + __builtin_ctz(m);
+
+    p += 32;
   }
+#endif
+#if defined(__SSE2__)
+  const __m128i quote16     = _mm_set1_epi8('"');
+  const __m128i backslash16 = _mm_set1_epi8('\\');
 
-  if (c == '"')
+  while (limit - p >= 16)
   {
-    char*  buf = NULL;
-    size_t len = 0;
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i x = _mm_or_si128(_mm_cmpeq_epi8(v, quote16),
+                             _mm_cmpeq_epi8(v, backslash16));
 
-    ssize_t size = getdelim(&buf, &len, '"', fd);
+    unsigned int m = _mm_movemask_epi8(x);
 
-    buf[size - 1] = '\0';
+    if (m)
+      return p + __builtin_ctz(m);
 
-    val_p->str = strdup(buf);
-    loc_p->last_column += size;
+    p += 16;
+  }
+#endif
 
-    free(buf);
+  while (p < limit && *p != '"' && *p != '\\')
+    ++p;
 
-    return STR;
-  }
+  return p;
+}
 
-  if (isdigit(c) || c == '-')
+
+
+
+/**
+ * @brief Read 4 hexadecimal digits.
+ *
+ * @param [in] p The digits.
+ *
+ * @return The value, or -1 if a digit is invalid.
+ */
+static long read_hex4(const char* p)
+{
+  long x = 0;
+
+  for (int i=0; i < 4; ++i)
   {
-    double x = 0;
+    int c = (unsigned char)p[i];
 
-    int n;
+    x <<= 4;
 
-    ungetc(c, fd);
+    if (c >= '0' && c <= '9')
+      x |= c - '0';
+    else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+      x |= (c | 0x20) - 'a' + 10;
+    else
+      return -1;
+  }
 
-    --(loc_p->last_column);
+  return x;
+}
 
-    fscanf(fd, "%lf%n", &x, &n);
 
-    val_p->num = x;
 
-    loc_p->last_column += n;
 
-    return NUM;
-  }
+/**
+ * @brief Decode the escape sequences of a string.
+ *
+ * @param [out] dst The decoded string. Must be as large as the source;
+ * escape sequences never grow once decoded. It can be the source
+ * itself.
+ *
+ * @param [in] src The raw string, without quotes.
+ *
+ * @param [in] len The length of the raw string.
+ *
+ * @return The length of the decoded string, or -1 if an escape
+ * sequence is invalid.
+ */
+static ssize_t unescape(char* dst, const char* src, size_t len)
+{
+  const char* end   = src + len;
+  char*       start = dst;
 
-  if (isalpha(c))
+  for (;;)
   {
-    ungetc(c, fd);
+    const char* q = memchr(src, '\\', end - src);
+
+    if (q == NULL)
+      q = end;
 
-    --(loc_p->last_column);
+    memmove(dst, src, q - src);
+    dst += q - src;
+    src  = q;
 
-    char* buf = NULL;
+    if (src == end)
+      break;
 
-    ssize_t n = get_word(&buf, fd);
+    if (JSON_unlikely(end - src < 2))
+      return -1;
 
-    if (n)
+    switch (src[1])
     {
-      if (strcmp(buf, "true") == 0)
+    case '"':  *dst++ = '"';  break;
+    case '\\': *dst++ = '\\'; break;
+    case '/':  *dst++ = '/';  break;
+    case 'b':  *dst++ = '\b'; break;
+    case 'f':  *dst++ = '\f'; break;
+    case 'n':  *dst++ = '\n'; break;
+    case 'r':  *dst++ = '\r'; break;
+    case 't':  *dst++ = '\t'; break;
+    case 'u':
+    {
+      if (JSON_unlikely(end - src < 6))
+        return -1;
+
+      long cp = read_hex4(src + 2);
+
+      if (JSON_unlikely(cp < 0 || (cp >= 0xDC00 && cp <= 0xDFFF)))
+        return -1;
+
+      /*  High surrogate, must be followed by a low surrogate  */
+      if (cp >= 0xD800 && cp <= 0xDBFF)
+      {
+        if (JSON_unlikely(end - src < 12 || src[6] != '\\' || src[7] != 'u'))
+          return -1;
+
+        long low = read_hex4(src + 8);
+
+        if (JSON_unlikely(low < 0xDC00 || low > 0xDFFF))
+          return -1;
+
+        cp   = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        src += 6;
+      }
+
+      /*  Encode in UTF-8  */
+      if (cp < 0x80)
+      {
+        *dst++ = cp;
+      }
+      else if (cp < 0x800)
       {
-        val_p->bool = 1;
-        loc_p->last_column += n;
-        free(buf);
-        return BOOL;
+        *dst++ = 0xC0 | (cp >> 6);
+        *dst++ = 0x80 | (cp & 0x3F);
       }
-      else if (strcmp(buf, "false") == 0)
+      else if (cp < 0x10000)
       {
-        val_p->bool = -1;
-        loc_p->last_column += n;
-        free(buf);
-        return BOOL;
+        *dst++ = 0xE0 | (cp >> 12);
+        *dst++ = 0x80 | ((cp >> 6) & 0x3F);
+        *dst++ = 0x80 | (cp & 0x3F);
       }
-      else if (strcmp(buf, "null") == 0)
+      else
       {
-        val_p->bool = 0;
-        loc_p->last_column += n;
-        free(buf);
-        return BOOL;
+        *dst++ = 0xF0 | (cp >> 18);
+        *dst++ = 0x80 | ((cp >> 12) & 0x3F);
+        *dst++ = 0x80 | ((cp >> 6) & 0x3F);
+        *dst++ = 0x80 | (cp & 0x3F);
       }
 
-      for (int i=n-1; i >= 0; --i)
+      src += 4;
+      break;
+    }
+    default:
+      return -1;
+    }
+
+    src += 2;
+  }
+
+  return dst - start;
+}
+
+
+
+
+/**
+ * @brief Read a string up to its closing quote and decode it.
+ *
+ * The raw string is first scanned for its closing quote, skipping the
+ * escaped characters. Then, it's copied once in a single allocation,
+ * decoding the escape sequences on the way if there's any. An in situ
+ * reader isn't copied: the string is decoded where it is, and its
+ * closing quote becomes its NUL terminator.
+ *
+ * @param [in,out] reader The reader to read from. The cursor is just
+ * after the opening quote.
+ *
+ * @param [in] alloc The allocator of the string.
+ *
+ * @param [out] len The length of the raw string.
+ *
+ * @return The decoded string, or @b NULL if it has no closing quote,
+ * if an escape sequence is invalid or on allocation failure.
+ */
+static char* read_string(JSON_Reader* reader, const JSON_Allocator* alloc, size_t* len)
+{
+  size_t offset  = 0;
+  int    escaped = 0;
+
+  const char* q;
+
+  reader->mark = reader->cursor;
+
+  for (;;)
+  {
+    q = find_special(reader->mark + offset, reader->limit);
+
+    if (JSON_likely(q < reader->limit))
+    {
+      if (*q == '"')
+        break;
+
+      escaped = 1;
+
+      /*  Skip the escaped character, if it's already there  */
+      if (JSON_likely(q + 1 < reader->limit))
+      {
+        offset = q + 2 - reader->mark;
+        continue;
+      }
+    }
+
+    offset = q - reader->mark;
+
+    reader->cursor = reader->limit;
+
+    if (JSON_FillReader(reader) == 0)
+    {
+      reader->mark = NULL;
+      return NULL;
+    }
+  }
+
+  *len = q - reader->mark;
+
+  char* str = reader->insitu ? (char*)reader->mark
+                             : alloc->alloc(alloc->ctx, *len + 1);
+
+  if (JSON_likely(str != NULL))
+  {
+    if (JSON_likely(!escaped))
+    {
+      if (!reader->insitu)
+        memcpy(str, reader->mark, *len);
+
+      str[*len] = '\0';
+    }
+    else
+    {
+      ssize_t n = unescape(str, reader->mark, *len);
+
+      if (JSON_unlikely(n < 0))
+      {
+        if (!reader->insitu)
+          alloc->free(alloc->ctx, str);
+
+        str = NULL;
+      }
+      else
       {
-        ungetc(buf[i], fd);
+        str[n] = '\0';
       }
+    }
+  }
+
+  reader->cursor = q + 1;
+  reader->mark   = NULL;
+
+  return str;
+}
 
-      free(buf);
+
+
+
+/**
+ * @brief JSON Lexer.
+ *
+ * @param [out] val_p Pointer to the value used by JSON_parser
+ *
+ * @param [out] loc_p Pointer to the location used by JSON_Parser
+ *
+ * @param [in] reader The reader to read from
+ *
+ * @param [in] alloc The allocator of the strings.
+ *
+ * @return Token type.
+ */
+int JSON_yylex(JSON_YYSTYPE* val_p, JSON_YYLTYPE* loc_p, JSON_Reader* reader,
+               const JSON_Allocator* alloc)
+{
+  int c = reader->next ? skip_indexed(reader, loc_p) : skip_ws(reader, loc_p);
+
+  loc_p->first_line = loc_p->last_line;
+  loc_p->first_column = loc_p->last_column;
+
+  if (c == EOF)
+    return 0;
+
+  if (c == '"')
+  {
+    size_t len;
+
+    ++reader->cursor;
+
+    val_p->str = read_string(reader, alloc, &len);
+
+    if (JSON_unlikely(val_p->str == NULL))
+      return c;
+
+    loc_p->last_column += len + 2;
+
+    return STR;
+  }
+
+  if (isdigit(c) || c == '-')
+  {
+    size_t n = read_span(reader, NUMBER);
+
+    ssize_t parsed = JSON_ParseNumber(reader->mark, reader->cursor, &val_p->number);
+
+    reader->mark = NULL;
+
+    loc_p->last_column += n;
+
+    /*  The whole span must be a valid number  */
+    if (JSON_unlikely(parsed != (ssize_t)n))
+      return c;
+
+    if (reader->next && JSON_unlikely(!ends_indexed(reader)))
+      return c;
+
+    return NUM;
+  }
+
+  if (isalpha(c))
+  {
+    size_t n = read_span(reader, WORD);
+
+    const char* word = reader->mark;
+
+    reader->mark = NULL;
+
+    if (reader->next && JSON_unlikely(!ends_indexed(reader)))
+      n = 0;
+
+    if (n == 4 && memcmp(word, "true", 4) == 0)
+    {
+      val_p->bool = 1;
+      loc_p->last_column += n;
+      return BOOL;
+    }
+    else if (n == 5 && memcmp(word, "false", 5) == 0)
+    {
+      val_p->bool = -1;
+      loc_p->last_column += n;
+      return BOOL;
     }
+    else if (n == 4 && memcmp(word, "null", 4) == 0)
+    {
+      val_p->bool = 0;
+      loc_p->last_column += n;
+      return BOOL;
+    }
+
+    /*  Not a keyword, only the first character is consumed  */
+    reader->cursor = word;
   }
 
+  ++reader->cursor;
+  ++(loc_p->last_column);
+
   return c;
 }
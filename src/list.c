@@ -24,6 +24,9 @@
 /*=============================================================================+
  |                                  Includes                                   |
  +=============================================================================*/
+#include <string.h>
+
+#include "allocator.h"
 #include "commons.h"
 #include "error.h"
 #include "json.h"
@@ -36,8 +39,10 @@
  |                                   Macros                                    |
  +=============================================================================*/
 #define RESIZE_LIST(SIZE,LIST) \
+  (LIST)->elements = (LIST)->alloc->realloc((LIST)->alloc->ctx, (LIST)->elements, \
+                                            sizeof(struct JSON_Type*) * (LIST)->size, \
+                                            sizeof(struct JSON_Type*) * (SIZE)); \
   (LIST)->size = (SIZE); \
-  (LIST)->elements = realloc((LIST)->elements, sizeof(struct JSON_Type*) * (LIST)->size); \
   if (JSON_unlikely(!(LIST)->elements)) \
   { \
     __JSON_SetError(JSON_ELIST_FAILED_REALLOC); \
@@ -48,6 +53,14 @@
  |                          Function Implementations                           |
  +=============================================================================*/
 JSON_List* JSON_MallocList(size_t size)
+{
+  return JSON_MallocListWith(NULL, size);
+}
+
+
+
+
+JSON_List* JSON_MallocListWith(const JSON_Allocator* alloc, size_t size)
 {
   if (size == 0)
   {
@@ -55,12 +68,16 @@ JSON_List* JSON_MallocList(size_t size)
     return NULL;
   }
 
-  JSON_List* list = calloc(1, sizeof(JSON_List));
+  if (alloc == NULL)
+    alloc = &JSON_DefaultAllocator;
+
+  JSON_List* list = JSON_AllocZero(alloc, sizeof(JSON_List));
 
   if (JSON_likely(list != NULL))
   {
     list->size     = size;
-    list->elements = calloc(size, sizeof(JSON_Type*));
+    list->alloc    = alloc;
+    list->elements = JSON_AllocZero(alloc, size * sizeof(JSON_Type*));
   }
 
   return list;
@@ -76,17 +93,17 @@ void JSON_FreeList(JSON_List* list)
     /*  Free Vector  */
     if (JSON_likely(list->elements != NULL))
     {
-      for (size_t i = 0; i < list->size; ++i)
+      for (size_t i = 0; i < list->index; ++i)
       {
         JSON_Type* ptr = list->elements[i];
 
-        JSON_FreeType(ptr);
+        JSON_FreeTypeWith(list->alloc, ptr);
       }
 
-      free(list->elements);
+      list->alloc->free(list->alloc->ctx, list->elements);
     }
 
-    free(list);
+    list->alloc->free(list->alloc->ctx, list);
   }
 }
 
@@ -110,6 +127,28 @@ int JSON_PushList(JSON_Type* type, JSON_List* list)
 
 
 
+int JSON_AppendList(JSON_List* list, JSON_List* other)
+{
+  size_t need = list->index + other->index;
+
+  /*  Resize once, to at least double  */
+  if (JSON_unlikely(need > list->size))
+  {
+    RESIZE_LIST(need > 2 * list->size ? need : 2 * list->size, list)
+  }
+
+  memcpy(list->elements + list->index, other->elements,
+         other->index * sizeof(JSON_Type*));
+
+  list->index  = need;
+  other->index = 0;
+
+  return 0;
+}
+
+
+
+
 int JSON_InsertList(JSON_Type* value, size_t index,  JSON_List* list)
 {
   /*  Check if valid index  */
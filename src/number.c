@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file number.c
+ *
+ * @brief JSON number parser implementation.
+ *
+ * A number is read as a decimal significand @b w and a power of ten
+ * @b q. Then:
+ *
+ * - If w is at most 2^53 and |q| at most 22, both are exact doubles
+ *   and a single multiplication or division is correctly rounded.
+ *
+ * - Otherwise, the Eisel-Lemire algorithm multiplies w by a 128 bits
+ *   approximation of 5^q and rounds the result to the nearest double.
+ *
+ * - If w doesn't fit in 19 digits, it's truncated and the rounding
+ *   can't be decided, strtod does the work in the C locale.
+ *
+ * Integers skip all of that: w is the value.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#define _GNU_SOURCE
+#include <locale.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commons.h"
+#include "number.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+#define SMALLEST_POWER (-342)  /**< Smallest power of ten in the table */
+#define LARGEST_POWER  308     /**< Largest power of ten in the table */
+#define MANTISSA_BITS  52      /**< Explicit bits of a double mantissa */
+#define MIN_EXPONENT   (-1023) /**< Exponent bias of a double */
+#define INFINITE_POWER 0x7FF   /**< Biased exponent of infinity */
+
+#define IS_DIGIT(C) ((unsigned char)((C) - '0') < 10)
+
+
+
+
+/*=============================================================================+
+ |                              Global Variables                               |
+ +=============================================================================*/
+/** 128 bits approximations of 5^q; see pow5.c */
+extern const uint64_t __JSON_Pow5[];
+
+/** The C locale of strtod_l, created before main(). */
+static locale_t c_locale = (locale_t)0;
+
+/** Powers of ten exactly representable as doubles. */
+static const double exact_powers[] =
+{
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Full 64 bits by 64 bits multiplication.
+ */
+static void multiply(uint64_t a, uint64_t b, uint64_t* high, uint64_t* low)
+{
+  unsigned __int128 r = (unsigned __int128)a * b;
+
+  *high = r >> 64;
+  *low  = (uint64_t)r;
+}
+
+
+
+
+/**
+ * @brief Compute the bits of the double nearest to w * 10^q.
+ *
+ * @param [in] q The power of ten.
+ *
+ * @param [in] w The non zero decimal significand.
+ *
+ * @return The bits of the positive double.
+ */
+static uint64_t eisel_lemire(int64_t q, uint64_t w)
+{
+  if (q < SMALLEST_POWER)
+    return 0;
+
+  if (q > LARGEST_POWER)
+    return (uint64_t)INFINITE_POWER << MANTISSA_BITS;
+
+  const uint64_t* pow5 = __JSON_Pow5 + 2 * (q - SMALLEST_POWER);
+
+  int lz = __builtin_clzll(w);
+
+  w <<= lz;
+
+  uint64_t high, low;
+
+  multiply(w, pow5[0], &high, &low);
+
+  /*  Only the upper bits are needed. Refine with the lower half of the
+   *  power only if they might be off by one  */
+  const uint64_t precision_mask = UINT64_MAX >> (MANTISSA_BITS + 3);
+
+  if ((high & precision_mask) == precision_mask)
+  {
+    uint64_t high2, low2;
+
+    multiply(w, pow5[1], &high2, &low2);
+
+    low += high2;
+
+    if (high2 > low)
+      ++high;
+  }
+
+  int upperbit = high >> 63;
+  int shift    = upperbit + 64 - MANTISSA_BITS - 3;
+
+  uint64_t mantissa = high >> shift;
+  int32_t  power2   = (int32_t)((((152170 + 65536) * q) >> 16) + 63)
+                      + upperbit - lz - MIN_EXPONENT;
+
+  /*  Subnormal  */
+  if (power2 <= 0)
+  {
+    if (-power2 + 1 >= 64)
+      return 0;
+
+    mantissa >>= -power2 + 1;
+    mantissa  += mantissa & 1;
+    mantissa >>= 1;
+
+    power2 = mantissa < (1ULL << MANTISSA_BITS) ? 0 : 1;
+
+    return mantissa | ((uint64_t)power2 << MANTISSA_BITS);
+  }
+
+  /*  Exactly in between two doubles, round to even  */
+  if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1)
+  {
+    if ((mantissa << shift) == high)
+      mantissa &= ~1ULL;
+  }
+
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+
+  if (mantissa >= (2ULL << MANTISSA_BITS))
+  {
+    mantissa = 1ULL << MANTISSA_BITS;
+    ++power2;
+  }
+
+  mantissa &= ~(1ULL << MANTISSA_BITS);
+
+  if (power2 >= INFINITE_POWER)
+    return (uint64_t)INFINITE_POWER << MANTISSA_BITS;
+
+  return mantissa | ((uint64_t)power2 << MANTISSA_BITS);
+}
+
+
+
+
+/**
+ * @brief Check that an integer fits in 64 bits.
+ *
+ * @param [in] digits The digits of the integer.
+ *
+ * @param [in] count The number of digits.
+ *
+ * @param [in,out] w The value, as accumulated modulo 2^64. Recomputed
+ * if it might have overflowed.
+ *
+ * @return Non zero if it fits.
+ */
+static int fits_integer(const char* digits, size_t count, uint64_t* w)
+{
+  /*  10^19 - 1 < 2^64  */
+  if (JSON_likely(count <= 19))
+    return 1;
+
+  if (count > 20)
+    return 0;
+
+  uint64_t x = 0;
+
+  for (size_t i=0; i < count; ++i)
+  {
+    if (__builtin_mul_overflow(x, 10, &x) ||
+        __builtin_add_overflow(x, (uint64_t)(digits[i] - '0'), &x))
+      return 0;
+  }
+
+  *w = x;
+
+  return 1;
+}
+
+
+
+
+/**
+ * @brief Create the C locale, before main(), so the parse functions
+ * don't race to create it.
+ */
+__attribute__((constructor))
+static void init_locale(void)
+{
+  c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+}
+
+
+
+
+/**
+ * @brief Parse a number with strtod in the C locale.
+ *
+ * @param [in] p The number, already validated.
+ *
+ * @param [in] len The length of the number.
+ *
+ * @return The number.
+ */
+static double slow_path(const char* p, size_t len)
+{
+  char  tmp[128];
+  char* buf = tmp;
+  double x  = 0;
+
+  if (len >= sizeof(tmp))
+    buf = malloc(len + 1);
+
+  if (JSON_likely(buf != NULL))
+  {
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+
+    /*  Without the C locale, the locale of the process  */
+    if (JSON_likely(c_locale != (locale_t)0))
+      x = strtod_l(buf, NULL, c_locale);
+    else
+      x = strtod(buf, NULL);
+
+    if (buf != tmp)
+      free(buf);
+  }
+
+  return x;
+}
+
+
+
+
+ssize_t JSON_ParseNumber(const char* p, const char* end, JSON_Number* x)
+{
+  const char* start    = p;
+  int         negative = 0;
+
+  if (p < end && *p == '-')
+  {
+    negative = 1;
+    ++p;
+  }
+
+  if (JSON_unlikely(p == end || !IS_DIGIT(*p)))
+    return -1;
+
+  /*  Integer part, no leading zero  */
+  const char* digits = p;
+  uint64_t    w      = 0;
+  int64_t     q      = 0;
+
+  if (*p == '0')
+  {
+    ++p;
+  }
+  else
+  {
+    while (p < end && IS_DIGIT(*p))
+      w = 10 * w + (*p++ - '0');
+  }
+
+  size_t count = p - digits;
+
+  /*  Fraction  */
+  if (p < end && *p == '.')
+  {
+    const char* fraction = ++p;
+
+    while (p < end && IS_DIGIT(*p))
+      w = 10 * w + (*p++ - '0');
+
+    if (JSON_unlikely(p == fraction))
+      return -1;
+
+    q      = -(int64_t)(p - fraction);
+    count += p - fraction;
+  }
+
+  const char* significand_end = p;
+
+  /*  Exponent  */
+  if (p < end && (*p | 0x20) == 'e')
+  {
+    int     eneg = 0;
+    int64_t e    = 0;
+
+    ++p;
+
+    if (p < end && (*p == '+' || *p == '-'))
+      eneg = *p++ == '-';
+
+    if (JSON_unlikely(p == end || !IS_DIGIT(*p)))
+      return -1;
+
+    while (p < end && IS_DIGIT(*p))
+    {
+      /*  Saturate, anything that large is zero or infinity anyway  */
+      if (e < 0x10000000)
+        e = 10 * e + (*p - '0');
+
+      ++p;
+    }
+
+    q += eneg ? -e : e;
+  }
+
+  /*  Integer, if it fits in 64 bits. -0 is kept as a double  */
+  if (significand_end == digits + count && p == significand_end
+      && (w != 0 || !negative) && fits_integer(digits, count, &w))
+  {
+    if (!negative && w > INT64_MAX)
+    {
+      x->type      = JSON_UNSIGNED;
+      x->uinteger  = w;
+
+      return p - start;
+    }
+
+    if (!negative || w <= (uint64_t)INT64_MAX + 1)
+    {
+      x->type    = JSON_INTEGER;
+      x->integer = negative ? (int64_t)(0 - w) : (int64_t)w;
+
+      return p - start;
+    }
+  }
+
+  x->type = JSON_NUMBER;
+
+  /*  Leading zeros are not significant  */
+  if (JSON_unlikely(count > 19))
+  {
+    for (const char* z=digits; z < significand_end && (*z == '0' || *z == '.'); ++z)
+      count -= *z == '0';
+
+    /*  The significand overflowed  */
+    if (count > 19)
+    {
+      x->num = slow_path(start, p - start);
+      return p - start;
+    }
+  }
+
+  double d;
+
+  if (w == 0)
+  {
+    d = 0;
+  }
+  else if (q >= -22 && q <= 22 && w <= (1ULL << 53))
+  {
+    d = (double)w;
+    d = q < 0 ? d / exact_powers[-q] : d * exact_powers[q];
+  }
+  else
+  {
+    uint64_t bits = eisel_lemire(q, w);
+    memcpy(&d, &bits, sizeof(d));
+  }
+
+  x->num = negative ? -d : d;
+
+  return p - start;
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file parallel.c
+ *
+ * @brief Parallel parser of large lists implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "commons.h"
+#include "cursor.h"
+#include "parallel.h"
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @brief The state shared by the threads of a parse.
+ */
+typedef struct Pool
+{
+  const char** starts;  /**< The first element of every chunk. */
+  const char*  end;     /**< The end of the input. */
+  size_t       chunks;
+  JSON_Type**  results; /**< The list of every chunk. */
+
+  JSON_Hash hashFunc;
+  size_t    dictSize;
+  size_t    listSize;
+
+  pthread_mutex_t lock;   /**< Protects the members below. */
+  size_t          next;   /**< The next chunk to parse. */
+  int             status; /**< The first failure, or 0. */
+} Pool;
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Cut the list of a buffer in chunks of whole elements.
+ *
+ * @param [out] chunks The number of chunks.
+ *
+ * @return The first element of every chunk, to release with free(),
+ * or @b NULL if the buffer isn't a list or on failure.
+ */
+static const char** split(const char* buf, size_t len, size_t threads, size_t* chunks)
+{
+  JSON_Cursor root;
+  JSON_Cursor element = {NULL};
+
+  *chunks = 0;
+
+  if (JSON_OpenCursor(&root, buf, len) != 0 || JSON_CursorType(&root) != JSON_LIST)
+    return NULL;
+
+  size_t target = len / (threads * JSON_PARALLEL_SPLIT);
+
+  if (target < JSON_PARALLEL_MIN_CHUNK)
+    target = JSON_PARALLEL_MIN_CHUNK;
+  else if (target > JSON_PARALLEL_MAX_CHUNK)
+    target = JSON_PARALLEL_MAX_CHUNK;
+
+  /*  Every chunk but the last is at least the target  */
+  const char** starts = malloc((len / target + 1) * sizeof(const char*));
+
+  if (JSON_unlikely(starts == NULL))
+    return NULL;
+
+  const char* next = buf;
+
+  /*  An invalid element ends the walk, the parse of the last chunk reports it  */
+  while (JSON_CursorNext(&root, &element) == 0)
+  {
+    if (element.at >= next)
+    {
+      starts[(*chunks)++] = element.at;
+      next                = element.at + target;
+    }
+  }
+
+  return starts;
+}
+
+
+
+
+/**
+ * @brief Parse a chunk as a list: its elements in brackets, without the
+ * comma that follows them.
+ *
+ * @return Same as JSON_ParseBuffer().
+ */
+static int parse_chunk(Pool* pool, size_t i)
+{
+  const char* from = pool->starts[i];
+  const char* to   = pool->end;
+  int         last = i + 1 == pool->chunks;
+
+  /*  Only white spaces between the comma and the next chunk  */
+  if (!last)
+  {
+    for (to = pool->starts[i + 1]; *--to != ','; )
+      ;
+  }
+
+  size_t len  = to - from;
+  char*  copy = malloc(len + 2);
+
+  if (JSON_unlikely(copy == NULL))
+    return 2;
+
+  /*  The last chunk has the closing bracket of the list  */
+  copy[0] = '[';
+  memcpy(copy + 1, from, len);
+
+  if (!last)
+    copy[++len] = ']';
+
+  int retval = JSON_ParseBuffer(&pool->results[i], copy, len + 1, pool->hashFunc,
+                                pool->dictSize, pool->listSize);
+
+  free(copy);
+
+  return retval;
+}
+
+
+
+
+/**
+ * @brief Parse chunks until there's none left, or a failure.
+ */
+static void* work(void* arg)
+{
+  Pool* pool = arg;
+
+  pthread_mutex_lock(&pool->lock);
+
+  while (pool->status == 0 && pool->next < pool->chunks)
+  {
+    size_t i = pool->next++;
+
+    pthread_mutex_unlock(&pool->lock);
+
+    int retval = parse_chunk(pool, i);
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (retval != 0 && pool->status == 0)
+      pool->status = retval;
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+
+
+
+/**
+ * @brief Append the lists of the chunks to the first one.
+ *
+ * @return 0 on success, 2 on failure.
+ */
+static int stitch(Pool* pool)
+{
+  JSON_List* list  = pool->results[0]->list;
+  size_t     total = 0;
+
+  for (size_t i = 0; i < pool->chunks; ++i)
+    total += pool->results[i]->list->index;
+
+  if (total > list->size && JSON_ResizeList(total, list) != 0)
+    return 2;
+
+  for (size_t i = 1; i < pool->chunks; ++i)
+  {
+    JSON_AppendList(list, pool->results[i]->list);
+    JSON_FreeType(pool->results[i]);
+    pool->results[i] = NULL;
+  }
+
+  return 0;
+}
+
+
+
+
+int JSON_ParseArrayParallel(struct JSON_Type** type,
+                            JSON_Reader* reader,
+                            size_t threads,
+                            JSON_Hash hashFunc,
+                            size_t dictSize,
+                            size_t listSize)
+{
+  *type = NULL;
+
+  if (threads == 0)
+  {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+    threads = online > 0 ? online : 1;
+  }
+
+  /*  A stream can't be cut ahead  */
+  if (reader->fd || threads == 1)
+    return JSON_ParseReader(type, reader, hashFunc, dictSize, listSize);
+
+  Pool pool =
+  {
+    .end      = reader->limit,
+    .hashFunc = hashFunc,
+    .dictSize = dictSize,
+    .listSize = listSize,
+  };
+
+  pool.starts = split(reader->cursor, reader->limit - reader->cursor, threads,
+                      &pool.chunks);
+
+  if (pool.chunks < 2)
+  {
+    free(pool.starts);
+    return JSON_ParseReader(type, reader, hashFunc, dictSize, listSize);
+  }
+
+  reader->cursor = reader->limit;
+  pool.results   = calloc(pool.chunks, sizeof(JSON_Type*));
+
+  if (JSON_unlikely(pool.results == NULL))
+  {
+    free(pool.starts);
+    return 2;
+  }
+
+  if (threads > pool.chunks)
+    threads = pool.chunks;
+
+  pthread_t* ids     = malloc((threads - 1) * sizeof(pthread_t));
+  size_t     started = 0;
+
+  pthread_mutex_init(&pool.lock, NULL);
+
+  /*  The calling thread is one of them; fewer threads is only slower  */
+  while (ids && started < threads - 1
+         && pthread_create(&ids[started], NULL, work, &pool) == 0)
+    ++started;
+
+  work(&pool);
+
+  for (size_t i = 0; i < started; ++i)
+    pthread_join(ids[i], NULL);
+
+  pthread_mutex_destroy(&pool.lock);
+
+  if (pool.status == 0)
+    pool.status = stitch(&pool);
+
+  if (pool.status == 0)
+    *type = pool.results[0];
+  else
+  {
+    for (size_t i = 0; i < pool.chunks; ++i)
+      JSON_FreeType(pool.results[i]);
+  }
+
+  free(ids);
+  free(pool.results);
+  free(pool.starts);
+
+  return pool.status;
+}
@@ -29,6 +29,7 @@
  #include <stdlib.h>
  #include <string.h>
 
+ #include "descent.h"
  #include "parser.h"
 
 
@@ -37,29 +38,28 @@
 /*=============================================================================+
  |                                 Prototypes                                  |
  +=============================================================================*/
-  int JSON_lex(JSON_STYPE* val_p,
-               JSON_LTYPE* loc_p,
-               FILE* fd);
+  int JSON_yylex(JSON_YYSTYPE* val_p,
+                 JSON_YYLTYPE* loc_p,
+                 JSON_Reader* reader,
+                 const JSON_Allocator* alloc);
 
 
 
 
-  int JSON_parse(struct JSON_Type** obj_pp,
-                 FILE*              fd,
-                 JSON_Hash          hashFunc,
-                 size_t             dictSize,
-                 size_t             listSize);
+  void JSON_yyerror(JSON_YYLTYPE*      loc_p,
+                    struct JSON_Type** obj_pp,
+                    JSON_Reader*       reader,
+                    JSON_Hash          hashFunc,
+                    size_t             dictSize,
+                    size_t             listSize,
+                    const JSON_Allocator* alloc,
+                    JSON_InternTable*  keys,
+                    const char*        error);
 
 
 
 
-  void JSON_error(JSON_LTYPE*        loc_p,
-                  struct JSON_Type** obj_pp,
-                  FILE*              fd,
-                  JSON_Hash          hashFunc,
-                  size_t             dictSize,
-                  size_t             listSize,
-                  const char*        error);
+  static JSON_Type* set_entry(JSON_Dict* dict, JSON_Type* entry, JSON_InternTable* keys);
 %}
 
 
@@ -69,18 +69,139 @@
  |                              Bison Definitions                              |
  +=============================================================================*/
 %code requires {
+#include <stdio.h>
+
 #include "json.h"
+#include "allocator.h"
+#include "document.h"
 #include "error.h"
+#include "intern.h"
+#include "number.h"
+#include "reader.h"
+  /*  A NULL hash function selects JSON_DefaultHash()  */
   typedef size_t (*JSON_Hash) (const char*);
  }
 
 
 
 
+%code provides {
+  int JSON_parse(struct JSON_Type** obj_pp,
+                 FILE*              fd,
+                 JSON_Hash          hashFunc,
+                 size_t             dictSize,
+                 size_t             listSize);
+
+
+
+
+  int JSON_ParseReader(struct JSON_Type** obj_pp,
+                       JSON_Reader*       reader,
+                       JSON_Hash          hashFunc,
+                       size_t             dictSize,
+                       size_t             listSize);
+
+
+
+
+  int JSON_ParseReaderWith(struct JSON_Type**    obj_pp,
+                           JSON_Reader*          reader,
+                           const JSON_Allocator* alloc,
+                           JSON_Hash             hashFunc,
+                           size_t                dictSize,
+                           size_t                listSize);
+
+
+
+
+  int JSON_ParseBuffer(struct JSON_Type** obj_pp,
+                       const char*        buf,
+                       size_t             len,
+                       JSON_Hash          hashFunc,
+                       size_t             dictSize,
+                       size_t             listSize);
+
+
+
+
+  int JSON_ParseFile(struct JSON_Type** obj_pp,
+                     const char*        path,
+                     JSON_Hash          hashFunc,
+                     size_t             dictSize,
+                     size_t             listSize);
+
+
+
+
+  int JSON_ParseDocument(JSON_Document*     document,
+                         JSON_Reader*       reader,
+                         JSON_Hash          hashFunc,
+                         size_t             dictSize,
+                         size_t             listSize);
+
+
+
+
+  int JSON_ParseDocumentBuffer(JSON_Document*     document,
+                               const char*        buf,
+                               size_t             len,
+                               JSON_Hash          hashFunc,
+                               size_t             dictSize,
+                               size_t             listSize);
+
+
+
+
+  int JSON_ParseDocumentFile(JSON_Document*     document,
+                             const char*        path,
+                             JSON_Hash          hashFunc,
+                             size_t             dictSize,
+                             size_t             listSize);
+
+
+
+
+  int JSON_ParseDocumentInSitu(JSON_Document*     document,
+                               char*              buf,
+                               size_t             len,
+                               JSON_Hash          hashFunc,
+                               size_t             dictSize,
+                               size_t             listSize);
+
+
+
+
+  typedef int (*JSON_RecordFunc) (JSON_Document* record, void* ctx);
+
+
+
+
+  int JSON_NextRecord(JSON_Document*     document,
+                      JSON_Reader*       reader,
+                      JSON_Hash          hashFunc,
+                      size_t             dictSize,
+                      size_t             listSize);
+
+
+
+
+  int JSON_ParseRecords(JSON_Document*     document,
+                        JSON_Reader*       reader,
+                        JSON_RecordFunc    callback,
+                        void*              ctx,
+                        JSON_Hash          hashFunc,
+                        size_t             dictSize,
+                        size_t             listSize);
+ }
+
+
+
+
 %union {
   int                bool;
-  double             num;
+  JSON_Number        number;
   char*              str;
+  JSON_Key           key;
   struct JSON_Type*  type;
   struct JSON_Dict*  dict;
   struct JSON_List*  list;
@@ -89,27 +210,31 @@
 
 
 
-%define api.prefix {JSON_}
+%define api.prefix {JSON_yy}
 %debug
 %locations
 %define api.pure full
+%define api.push-pull both
 %error-verbose
 
 
 
 
 %parse-param {struct JSON_Type** type}
-%parse-param {FILE* fd}
+%parse-param {JSON_Reader* reader}
 %parse-param {JSON_Hash hashFunc}
 %parse-param {size_t dictSize}
 %parse-param {size_t listSize}
-%lex-param   {FILE* fd}
+%parse-param {const JSON_Allocator* alloc}
+%parse-param {JSON_InternTable* keys}
+%lex-param   {JSON_Reader* reader}
+%lex-param   {const JSON_Allocator* alloc}
 
 
 
 
 %token <bool> BOOL
-%token <num>  NUM
+%token <number> NUM
 %token <str>  STR
 
 %type <type> value
@@ -124,10 +249,10 @@
 
 
 
-%destructor {free($$);} STR
+%destructor {alloc->free(alloc->ctx, $$);} STR
 %destructor {JSON_FreeDict($$);} object entry_sequence
 %destructor {JSON_FreeList($$);} array  value_sequence
-%destructor {JSON_FreeType($$);} value  entry
+%destructor {JSON_FreeTypeWith(alloc, $$);} value  entry
 
 
 
@@ -139,13 +264,13 @@
 START:
 /*  Empty  */
 |
-START object
+object
 {
-  *type = JSON_MallocType(NULL, JSON_DICT);
+  *type = JSON_MallocTypeWith(alloc, NULL, JSON_DICT);
 
   if (*type)
   {
-    (*type)->dict = $2;
+    (*type)->dict = $1;
   }
   else
   {
@@ -154,13 +279,13 @@ START object
   }
 }
 |
-START array
+array
 {
-  *type = JSON_MallocType(NULL, JSON_LIST);
+  *type = JSON_MallocTypeWith(alloc, NULL, JSON_LIST);
 
   if (*type)
   {
-    (*type)->list = $2;
+    (*type)->list = $1;
   }
   else
   {
@@ -174,11 +299,29 @@ START array
 
 
 entry:
-STR ':' value
+STR
+{
+  $<key>$.str    = $1;
+  $<key>$.length = strlen($1);
+
+  /*  The copy of a known label is the last allocation, give it back  */
+  if (keys && JSON_InternString(keys, &$<key>$))
+  {
+    alloc->free(alloc->ctx, $1);
+    $1 = $<key>$.str;
+  }
+}
+':' value
 {
-  $3->label = strdup($1);
-  $$ = $3;
-  free($1);
+  $4->label = $1;
+
+  if (keys)
+  {
+    $4->hash   = $<key>2.hash;
+    $4->length = $<key>2.length;
+  }
+
+  $$ = $4;
 }
 ;
 
@@ -188,10 +331,10 @@ STR ':' value
 entry_sequence:
 entry
 {
-  $$ = JSON_MallocDict(dictSize, hashFunc);
+  $$ = JSON_MallocDictWith(alloc, dictSize, hashFunc);
 
   if ($$)
-    JSON_SetDictValue($$, $1); // Can't have overwriten value
+    set_entry($$, $1, keys); // Can't have overwriten value
   else
   {
     perror(JSON_GetError());
@@ -202,9 +345,17 @@ entry
 |
 entry_sequence ',' entry
 {
-  JSON_Type* ow = JSON_SetDictValue($1, $3);
+  JSON_Type* ow = set_entry($1, $3, keys);
 
-  JSON_FreeType(ow);
+  if (ow == $3)
+  {
+    fprintf(stderr, "%s", JSON_GetError());
+    JSON_FreeTypeWith(alloc, $3);
+    JSON_FreeDict($1);
+    YYABORT;
+  }
+
+  JSON_FreeTypeWith(alloc, ow);
 
   $$ = $1;
 }
@@ -236,7 +387,7 @@ array:
 value_sequence:
 value
 {
-  $$ = JSON_MallocList(listSize);
+  $$ = JSON_MallocListWith(alloc, listSize);
 
   if ($$)
   {
@@ -271,25 +422,25 @@ value_sequence ',' value
 value:
 STR
 {
-  $$ = JSON_MallocType(NULL, JSON_STRING);
+  $$ = JSON_MallocTypeWith(alloc, NULL, JSON_STRING);
 
   if ($$)
-    $$->str = strdup($1);
+    $$->str = $1;
   else
   {
+    alloc->free(alloc->ctx, $1);
     perror(JSON_GetError());
     YYABORT;
   }
-
-  free($1);
 }
 |
 NUM
 {
-  $$ = JSON_MallocType(NULL, JSON_NUMBER);
+  $$ = JSON_MallocTypeWith(alloc, NULL, $1.type);
 
+  /*  Every member of the union is 64 bits  */
   if ($$)
-    $$->num = $1;
+    $$->uinteger = $1.uinteger;
   else
   {
     perror(JSON_GetError());
@@ -299,7 +450,7 @@ NUM
 |
 object
 {
-  $$ = JSON_MallocType(NULL, JSON_DICT);
+  $$ = JSON_MallocTypeWith(alloc, NULL, JSON_DICT);
 
   if ($$)
     $$->dict = $1;
@@ -312,7 +463,7 @@ object
 |
 array
 {
-  $$ = JSON_MallocType(NULL, JSON_LIST);
+  $$ = JSON_MallocTypeWith(alloc, NULL, JSON_LIST);
 
   if ($$)
     $$->list = $1;
@@ -325,7 +476,7 @@ array
 |
 BOOL
 {
-  $$ = JSON_MallocType(NULL, JSON_BOOLEAN);
+  $$ = JSON_MallocTypeWith(alloc, NULL, JSON_BOOLEAN);
 
   if ($$)
     $$->bool = $1;
@@ -342,14 +493,20 @@ BOOL
 /*=============================================================================+
  |                                  Epilogue                                   |
  +=============================================================================*/
-void JSON_error(JSON_LTYPE* locP,
-                struct JSON_Type** type,
-                FILE* fd,
-                JSON_Hash hashFunc,
-                size_t dictSize,
-                size_t listSize,
-                const char* error)
+void JSON_yyerror(JSON_YYLTYPE* locP,
+                  struct JSON_Type** type,
+                  JSON_Reader* reader,
+                  JSON_Hash hashFunc,
+                  size_t dictSize,
+                  size_t listSize,
+                  const JSON_Allocator* alloc,
+                  JSON_InternTable* keys,
+                  const char* error)
 {
+  /*  A parse discarded by a JSON_PushParser, see push.c  */
+  if (reader == NULL)
+    return;
+
   fprintf(stderr, "%s at %d.%d-%d.%d\n",
           error,
           locP->first_line,
@@ -357,3 +514,277 @@ void JSON_error(JSON_LTYPE* locP,
           locP->first_column,
           locP->last_column);
 }
+
+
+
+
+/**
+ * @brief Set an entry in a dict, without hashing its label again if
+ * it was interned and the dict uses the same hash.
+ */
+static JSON_Type* set_entry(JSON_Dict* dict, JSON_Type* entry, JSON_InternTable* keys)
+{
+  if (keys && dict->hash == JSON_DefaultHash)
+    return JSON_SetDictHashedValue(dict, entry);
+
+  return JSON_SetDictValue(dict, entry);
+}
+
+
+
+
+int JSON_parse(struct JSON_Type** type,
+               FILE* fd,
+               JSON_Hash hashFunc,
+               size_t dictSize,
+               size_t listSize)
+{
+  JSON_Reader* reader = JSON_MallocReader(fd);
+
+  if (reader == NULL)
+  {
+    perror("JSON_MallocReader");
+    return 2;
+  }
+
+  int retval = JSON_EngineParse(type, reader, hashFunc, dictSize, listSize,
+                                &JSON_DefaultAllocator, NULL);
+
+  JSON_FreeReader(reader);
+
+  return retval;
+}
+
+
+
+
+int JSON_ParseReader(struct JSON_Type** type,
+                     JSON_Reader* reader,
+                     JSON_Hash hashFunc,
+                     size_t dictSize,
+                     size_t listSize)
+{
+  return JSON_ParseReaderWith(type, reader, NULL, hashFunc, dictSize, listSize);
+}
+
+
+
+
+int JSON_ParseReaderWith(struct JSON_Type** type,
+                         JSON_Reader* reader,
+                         const JSON_Allocator* alloc,
+                         JSON_Hash hashFunc,
+                         size_t dictSize,
+                         size_t listSize)
+{
+  if (alloc == NULL)
+    alloc = &JSON_DefaultAllocator;
+
+  return JSON_EngineParse(type, reader, hashFunc, dictSize, listSize, alloc, NULL);
+}
+
+
+
+
+int JSON_ParseBuffer(struct JSON_Type** type,
+                     const char* buf,
+                     size_t len,
+                     JSON_Hash hashFunc,
+                     size_t dictSize,
+                     size_t listSize)
+{
+  JSON_Reader reader;
+
+  JSON_InitReader(&reader, buf, len);
+
+  return JSON_EngineParse(type, &reader, hashFunc, dictSize, listSize,
+                          &JSON_DefaultAllocator, NULL);
+}
+
+
+
+
+int JSON_ParseFile(struct JSON_Type** type,
+                   const char* path,
+                   JSON_Hash hashFunc,
+                   size_t dictSize,
+                   size_t listSize)
+{
+  JSON_Reader reader;
+
+  if (JSON_OpenReader(&reader, path) != 0)
+  {
+    perror(path);
+    return -1;
+  }
+
+  int retval = JSON_EngineParse(type, &reader, hashFunc, dictSize, listSize,
+                                &JSON_DefaultAllocator, NULL);
+
+  JSON_CloseReader(&reader);
+
+  return retval;
+}
+
+
+
+
+int JSON_ParseDocument(JSON_Document* document,
+                       JSON_Reader* reader,
+                       JSON_Hash hashFunc,
+                       size_t dictSize,
+                       size_t listSize)
+{
+  JSON_ResetDocument(document);
+
+  return JSON_EngineParse(&document->root, reader, hashFunc, dictSize, listSize,
+                          &document->alloc, document->keys);
+}
+
+
+
+
+int JSON_ParseDocumentBuffer(JSON_Document* document,
+                             const char* buf,
+                             size_t len,
+                             JSON_Hash hashFunc,
+                             size_t dictSize,
+                             size_t listSize)
+{
+  JSON_Reader reader;
+
+  JSON_InitReader(&reader, buf, len);
+
+  return JSON_ParseDocument(document, &reader, hashFunc, dictSize, listSize);
+}
+
+
+
+
+int JSON_ParseDocumentFile(JSON_Document* document,
+                           const char* path,
+                           JSON_Hash hashFunc,
+                           size_t dictSize,
+                           size_t listSize)
+{
+  JSON_Reader reader;
+
+  if (JSON_OpenReader(&reader, path) != 0)
+  {
+    perror(path);
+    return -1;
+  }
+
+  int retval = JSON_ParseDocument(document, &reader, hashFunc, dictSize, listSize);
+
+  JSON_CloseReader(&reader);
+
+  return retval;
+}
+
+
+
+
+int JSON_ParseDocumentInSitu(JSON_Document* document,
+                             char* buf,
+                             size_t len,
+                             JSON_Hash hashFunc,
+                             size_t dictSize,
+                             size_t listSize)
+{
+  JSON_Reader reader;
+
+  JSON_InitReaderInSitu(&reader, buf, len);
+
+  return JSON_ParseDocument(document, &reader, hashFunc, dictSize, listSize);
+}
+
+
+
+
+/**
+ * @brief Find the end of the line at the cursor of a reader, reading
+ * the stream until there's one.
+ *
+ * @return The newline, or the limit of the reader at the end of the
+ * input.
+ */
+static const char* find_line(JSON_Reader* reader)
+{
+  size_t scanned = 0;
+
+  for (;;)
+  {
+    const char* from = reader->cursor + scanned;
+    const char* eol  = memchr(from, '\n', reader->limit - from);
+
+    if (eol)
+      return eol;
+
+    scanned = reader->limit - reader->cursor;
+
+    /*  Keep the line from the cursor  */
+    reader->mark = NULL;
+
+    if (JSON_FillReader(reader) == 0)
+      return reader->limit;
+  }
+}
+
+
+
+
+int JSON_NextRecord(JSON_Document* document,
+                    JSON_Reader* reader,
+                    JSON_Hash hashFunc,
+                    size_t dictSize,
+                    size_t listSize)
+{
+  for (;;)
+  {
+    const char* eol = find_line(reader);
+
+    if (reader->cursor == eol && eol == reader->limit)
+    {
+      JSON_ResetDocument(document);
+      return -1;
+    }
+
+    JSON_Reader line;
+
+    if (reader->insitu)
+      JSON_InitReaderInSitu(&line, (char*)reader->cursor, eol - reader->cursor);
+    else
+      JSON_InitReader(&line, reader->cursor, eol - reader->cursor);
+
+    reader->cursor = eol < reader->limit ? eol + 1 : eol;
+
+    int retval = JSON_ParseDocument(document, &line, hashFunc, dictSize, listSize);
+
+    /*  Skip blank lines  */
+    if (retval != 0 || document->root != NULL)
+      return retval;
+  }
+}
+
+
+
+
+int JSON_ParseRecords(JSON_Document* document,
+                      JSON_Reader* reader,
+                      JSON_RecordFunc callback,
+                      void* ctx,
+                      JSON_Hash hashFunc,
+                      size_t dictSize,
+                      size_t listSize)
+{
+  int retval;
+
+  while ((retval = JSON_NextRecord(document, reader, hashFunc, dictSize, listSize)) == 0)
+  {
+    if ((retval = callback(document, ctx)) != 0)
+      return retval;
+  }
+
+  return retval == -1 ? 0 : retval;
+}
@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file push.c
+ *
+ * @brief JSON_PushParser structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <ctype.h>
+#include <string.h>
+
+#include "commons.h"
+#include "push.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The initial capacity of the pending input. */
+#define PUSH_MIN_PENDING 256
+
+
+
+
+/*=============================================================================+
+ |                                 Prototypes                                  |
+ +=============================================================================*/
+int JSON_yylex(JSON_YYSTYPE* val_p, JSON_YYLTYPE* loc_p, JSON_Reader* reader,
+               const JSON_Allocator* alloc);
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+static inline int push_token(JSON_PushParser* parser, int token, JSON_YYSTYPE* val,
+                             JSON_Reader* reader)
+{
+  return JSON_yypush_parse(parser->state, token, val, &parser->loc, &parser->root,
+                           reader, parser->hashFunc, parser->dictSize,
+                           parser->listSize, &JSON_DefaultAllocator, NULL);
+}
+
+
+
+
+/**
+ * @brief Check if a token may go on in the next chunk: a number or a
+ * word up to the end of the chunk.
+ *
+ * @param [in] p The start of the token, maybe after white spaces.
+ */
+static int is_cut(int token, const char* p, const char* limit)
+{
+  if (token == STR || token == '{' || token == '}' || token == '['
+      || token == ']' || token == ',' || token == ':')
+    return 0;
+
+  while (p < limit && isspace((unsigned char)*p))
+    ++p;
+
+  while (p < limit && (isalnum((unsigned char)*p) || *p == '+' || *p == '-' || *p == '.'))
+    ++p;
+
+  return p == limit;
+}
+
+
+
+
+/**
+ * @brief Make room for @b size bytes of pending input.
+ *
+ * @return 0 on success, 2 on failure.
+ */
+static int reserve(JSON_PushParser* parser, size_t size)
+{
+  if (JSON_likely(size <= parser->size))
+    return 0;
+
+  size_t n = parser->size ? parser->size : PUSH_MIN_PENDING;
+
+  while (n < size)
+    n *= 2;
+
+  char* pending = realloc(parser->pending, n);
+
+  if (JSON_unlikely(pending == NULL))
+    return 2;
+
+  parser->pending = pending;
+  parser->size    = n;
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Keep the input left after a chunk, for the next one.
+ *
+ * @param [in] left The input left, in the chunk or already pending.
+ *
+ * @return 0 on success, 2 on failure.
+ */
+static int keep(JSON_PushParser* parser, const char* left, size_t len)
+{
+  if (len == 0)
+  {
+    parser->used = 0;
+    return 0;
+  }
+
+  /*  Already pending, moved to the start  */
+  if (left >= parser->pending && left < parser->pending + parser->used)
+  {
+    memmove(parser->pending, left, len);
+  }
+  else
+  {
+    if (JSON_unlikely(reserve(parser, len) != 0))
+      return 2;
+
+    memcpy(parser->pending, left, len);
+  }
+
+  parser->used = len;
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Tell if a character of a cut string is escaped.
+ *
+ * @param [in] buf The start of the chunk of the character.
+ *
+ * @param [in] at The character, or the end of the chunk.
+ *
+ * @return Non zero if an odd number of backslashes precede it, also
+ * counting those at the end of the previous chunks.
+ */
+static int is_escaped(const JSON_PushParser* parser, const char* buf, const char* at)
+{
+  const char* p = at;
+
+  while (p > buf && p[-1] == '\\')
+    --p;
+
+  return ((at - p) + (p == buf ? parser->escaped : 0)) & 1;
+}
+
+
+
+
+/**
+ * @brief Look for the closing quote of a cut string in a chunk.
+ *
+ * Only the chunk is read: where the string was cut, the previous chunks
+ * only leave whether their last backslash escapes the next character.
+ *
+ * @return Non zero if the chunk closes the string.
+ */
+static int closes_string(JSON_PushParser* parser, const char* buf, size_t len)
+{
+  const char* end = buf + len;
+  const char* p   = buf;
+
+  while ((p = memchr(p, '"', end - p)) != NULL)
+  {
+    if (!is_escaped(parser, buf, p))
+      return 1;
+
+    ++p;
+  }
+
+  parser->escaped = is_escaped(parser, buf, end);
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Lex a reader and push its tokens, until a document is complete
+ * or a token is cut by the end of the reader.
+ *
+ * @param [in] end Non zero if the input ended: the last token is
+ * complete, and the end of the input is pushed too.
+ *
+ * @return Same as JSON_PushParse().
+ */
+static int drive(JSON_PushParser* parser, JSON_Reader* reader, int end)
+{
+  for (;;)
+  {
+    const char*  start = reader->cursor;
+    JSON_YYLTYPE loc   = parser->loc;
+    JSON_YYSTYPE val;
+
+    int token = JSON_yylex(&val, &parser->loc, reader, &JSON_DefaultAllocator);
+
+    if (!end)
+    {
+      if (token == 0)
+        return JSON_PUSH_MORE;
+
+      /*  A string without closing quote, or a scalar up to the end,
+          goes on in the next chunk  */
+      parser->string = token == '"';
+
+      if (parser->string ? reader->cursor == reader->limit
+                         : is_cut(token, start, reader->limit))
+      {
+        /*  The opening quote stops the backslashes  */
+        parser->escaped = 0;
+        parser->escaped = parser->string && is_escaped(parser, start, reader->limit);
+
+        reader->cursor = start;
+        parser->loc    = loc;
+        return JSON_PUSH_MORE;
+      }
+    }
+
+    int retval = push_token(parser, token, &val, reader);
+
+    if (retval != YYPUSH_MORE)
+      return retval;
+
+    if (token == '{' || token == '[')
+    {
+      ++parser->depth;
+    }
+    else if ((token == '}' || token == ']') && --parser->depth == 0)
+    {
+      /*  The end of the document, without waiting for the input's  */
+      return push_token(parser, 0, &val, reader);
+    }
+  }
+}
+
+
+
+
+/**
+ * @brief Parse the pending input and a chunk.
+ */
+static int parse(JSON_PushParser* parser, const char* buf, size_t len,
+                 JSON_Type** type, int end)
+{
+  JSON_Reader reader;
+
+  *type = NULL;
+
+  /*  Lex the chunk in place, unless a token was cut  */
+  if (parser->used == 0)
+  {
+    JSON_InitReader(&reader, buf, len);
+  }
+  else
+  {
+    /*  Don't lex a cut string again before its closing quote  */
+    int more = parser->string && !end && !closes_string(parser, buf, len);
+
+    if (JSON_unlikely(reserve(parser, parser->used + len) != 0))
+    {
+      JSON_ResetPushParser(parser);
+      return 2;
+    }
+
+    if (len > 0)
+      memcpy(parser->pending + parser->used, buf, len);
+
+    parser->used += len;
+
+    if (more)
+      return JSON_PUSH_MORE;
+
+    JSON_InitReader(&reader, parser->pending, parser->used);
+  }
+
+  int retval = drive(parser, &reader, end);
+
+  /*  The Bison parser released the document  */
+  if (retval == 1 || retval == 2)
+    parser->depth = 0;
+
+  if (retval == JSON_PUSH_MORE || retval == 0)
+  {
+    if (JSON_likely(keep(parser, reader.cursor, reader.limit - reader.cursor) == 0))
+    {
+      if (retval == 0)
+      {
+        *type         = parser->root;
+        parser->root  = NULL;
+        parser->depth = 0;
+        parser->loc   = (JSON_YYLTYPE) {1, 1, 1, 1};
+      }
+
+      return retval;
+    }
+
+    JSON_FreeType(parser->root);
+    parser->root = NULL;
+    retval       = 2;
+  }
+
+  JSON_ResetPushParser(parser);
+
+  return retval;
+}
+
+
+
+
+JSON_PushParser* JSON_MallocPushParser(JSON_Hash hashFunc,
+                                       size_t dictSize,
+                                       size_t listSize)
+{
+  JSON_PushParser* parser = calloc(1, sizeof(JSON_PushParser));
+
+  if (JSON_likely(parser != NULL))
+  {
+    parser->state    = JSON_yypstate_new();
+    parser->loc      = (JSON_YYLTYPE) {1, 1, 1, 1};
+    parser->hashFunc = hashFunc;
+    parser->dictSize = dictSize;
+    parser->listSize = listSize;
+
+    if (JSON_unlikely(parser->state == NULL))
+    {
+      free(parser);
+      return NULL;
+    }
+  }
+
+  return parser;
+}
+
+
+
+
+void JSON_FreePushParser(JSON_PushParser* parser)
+{
+  if (parser)
+  {
+    JSON_ResetPushParser(parser);
+    JSON_yypstate_delete(parser->state);
+
+    free(parser->pending);
+    free(parser);
+  }
+}
+
+
+
+
+void JSON_ResetPushParser(JSON_PushParser* parser)
+{
+  /*  The end of the input is an error in a document, which makes the
+      Bison parser release what it holds; without reader, it's quiet  */
+  if (parser->depth > 0)
+  {
+    JSON_YYSTYPE val = {0};
+
+    push_token(parser, 0, &val, NULL);
+  }
+
+  JSON_FreeType(parser->root);
+
+  parser->root   = NULL;
+  parser->depth  = 0;
+  parser->used   = 0;
+  parser->string  = 0;
+  parser->escaped = 0;
+  parser->loc     = (JSON_YYLTYPE) {1, 1, 1, 1};
+}
+
+
+
+
+int JSON_PushParse(JSON_PushParser* parser, const char* buf, size_t len,
+                   JSON_Type** type)
+{
+  return parse(parser, buf, len, type, 0);
+}
+
+
+
+
+int JSON_PushEnd(JSON_PushParser* parser, JSON_Type** type)
+{
+  return parse(parser, NULL, 0, type, 1);
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file reader.c
+ *
+ * @brief JSON_Reader structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "commons.h"
+#include "reader.h"
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Allocate an aligned block.
+ *
+ * @param [in] size The size of the block.
+ *
+ * @return A pointer to the block or @b NULL on failure.
+ */
+static char* malloc_block(size_t size)
+{
+  void* block = NULL;
+
+  if (JSON_unlikely(posix_memalign(&block, JSON_READER_ALIGN, size) != 0))
+    return NULL;
+
+  return block;
+}
+
+
+
+
+JSON_Reader* JSON_MallocReader(FILE* fd)
+{
+  JSON_Reader* reader = calloc(1, sizeof(JSON_Reader));
+
+  if (JSON_likely(reader != NULL))
+  {
+    reader->fd    = fd;
+    reader->size  = JSON_READER_BLOCK;
+    reader->block = malloc_block(reader->size);
+
+    if (JSON_unlikely(reader->block == NULL))
+    {
+      free(reader);
+      return NULL;
+    }
+
+    reader->cursor = reader->block;
+    reader->limit  = reader->block;
+  }
+
+  return reader;
+}
+
+
+
+
+void JSON_InitReader(JSON_Reader* reader, const char* buf, size_t len)
+{
+  reader->cursor = buf;
+  reader->limit  = buf + len;
+  reader->mark   = NULL;
+  reader->block  = NULL;
+  reader->size   = 0;
+  reader->owner  = 0;
+  reader->insitu = 0;
+  reader->fd     = NULL;
+  reader->base   = NULL;
+  reader->next   = NULL;
+  reader->last   = NULL;
+}
+
+
+
+
+void JSON_InitReaderInSitu(JSON_Reader* reader, char* buf, size_t len)
+{
+  JSON_InitReader(reader, buf, len);
+
+  reader->insitu = 1;
+}
+
+
+
+
+int JSON_OpenReader(JSON_Reader* reader, const char* path)
+{
+  struct stat st;
+
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0)
+    return -1;
+
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  /*  Can't be mapped, read it as a stream  */
+  if (!S_ISREG(st.st_mode))
+  {
+    JSON_InitReader(reader, NULL, 0);
+
+    reader->size  = JSON_READER_BLOCK;
+    reader->block = malloc_block(reader->size);
+    reader->fd    = fdopen(fd, "r");
+
+    if (reader->block == NULL || reader->fd == NULL)
+    {
+      free(reader->block);
+
+      if (reader->fd)
+        fclose(reader->fd);
+      else
+        close(fd);
+
+      return -1;
+    }
+
+    reader->cursor = reader->block;
+    reader->limit  = reader->block;
+    reader->owner  = 1;
+
+    return 0;
+  }
+
+  char*  map  = NULL;
+  size_t size = st.st_size;
+
+  /*  Can't map an empty file  */
+  if (size > 0)
+  {
+    map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map == MAP_FAILED)
+    {
+      close(fd);
+      return -1;
+    }
+
+    /*  Hints only, failures are harmless  */
+#ifdef MADV_SEQUENTIAL
+    madvise(map, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+    madvise(map, size, MADV_HUGEPAGE);
+#endif
+  }
+
+  /*  The mapping stay valid after closing the file  */
+  close(fd);
+
+  JSON_InitReader(reader, map, size);
+
+  reader->block = map;
+  reader->size  = size;
+  reader->owner = 1;
+
+  return 0;
+}
+
+
+
+
+void JSON_CloseReader(JSON_Reader* reader)
+{
+  if (reader->owner)
+  {
+    if (reader->fd)
+    {
+      fclose(reader->fd);
+      free(reader->block);
+    }
+    else if (reader->block)
+    {
+      munmap(reader->block, reader->size);
+    }
+  }
+
+  JSON_InitReader(reader, NULL, 0);
+}
+
+
+
+
+void JSON_FreeReader(JSON_Reader* reader)
+{
+  if (reader)
+  {
+    free(reader->block);
+
+    free(reader);
+  }
+}
+
+
+
+
+size_t JSON_FillReader(JSON_Reader* reader)
+{
+  if (reader->fd == NULL)
+    return 0;
+
+  /*  Bytes to keep at the start of the block  */
+  const char* keep   = reader->mark ? reader->mark : reader->cursor;
+  size_t      kept   = reader->limit - keep;
+  size_t      offset = reader->cursor - keep;
+
+  /*  The token doesn't leave room for a whole block, grow  */
+  if (JSON_unlikely(kept + JSON_READER_BLOCK > reader->size))
+  {
+    size_t size  = 2 * reader->size;
+    char*  block = malloc_block(size);
+
+    if (JSON_unlikely(block == NULL))
+      return 0;
+
+    memcpy(block, keep, kept);
+    free(reader->block);
+
+    reader->block = block;
+    reader->size  = size;
+  }
+  else
+  {
+    memmove(reader->block, keep, kept);
+  }
+
+  size_t n = fread(reader->block + kept, 1, reader->size - kept, reader->fd);
+
+  if (JSON_unlikely(n == 0 && ferror(reader->fd)))
+    perror("Lexer EOF");
+
+  if (reader->mark)
+    reader->mark = reader->block;
+
+  reader->cursor = reader->block + offset;
+  reader->limit  = reader->block + kept + n;
+
+  return n;
+}
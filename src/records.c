@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file records.c
+ *
+ * @brief Parallel parser of JSON Lines implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "commons.h"
+#include "descent.h"
+#include "document.h"
+#include "records.h"
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @brief The state shared by the threads of a parse.
+ */
+typedef struct Pool
+{
+  const char*   buf;
+  const size_t* bounds; /**< The offset of every chunk, and the end. */
+  size_t        chunks;
+
+  JSON_RecordFunc callback;
+  void*           ctx;
+  int             ordered;
+
+  JSON_Hash hashFunc;
+  size_t    dictSize;
+  size_t    listSize;
+
+  pthread_mutex_t lock;   /**< Protects the members below. */
+  pthread_cond_t  turned; /**< Signaled when @b turn moves. */
+  size_t          next;   /**< The next chunk to parse. */
+  size_t          turn;   /**< The next chunk to deliver, in order. */
+  int             status; /**< The first failure, or 0. */
+} Pool;
+
+
+
+
+/**
+ * @brief The records of a chunk, waiting for their turn.
+ */
+typedef struct Batch
+{
+  JSON_Type** roots;
+  size_t      count;
+  size_t      size;
+} Batch;
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Cut a buffer in chunks of whole lines.
+ *
+ * @param [out] chunks The number of chunks.
+ *
+ * @return The offsets of the chunks followed by the length, to release
+ * with free(), or @b NULL on failure.
+ */
+static size_t* split(const char* buf, size_t len, size_t threads, size_t* chunks)
+{
+  size_t target = len / (threads * JSON_RECORDS_SPLIT);
+
+  if (target < JSON_RECORDS_CHUNK)
+    target = JSON_RECORDS_CHUNK;
+
+  /*  Every chunk but the last is at least the target  */
+  size_t* bounds = malloc((len / target + 2) * sizeof(size_t));
+
+  if (JSON_unlikely(bounds == NULL))
+    return NULL;
+
+  size_t n = 0;
+
+  bounds[0] = 0;
+
+  while (bounds[n] < len)
+  {
+    size_t end = bounds[n] + target;
+
+    if (end >= len)
+    {
+      end = len;
+    }
+    else
+    {
+      const char* eol = memchr(buf + end, '\n', len - end);
+
+      end = eol ? (size_t)(eol - buf) + 1 : len;
+    }
+
+    bounds[++n] = end;
+  }
+
+  *chunks = n;
+
+  return bounds;
+}
+
+
+
+
+static int push_root(Batch* batch, JSON_Type* root)
+{
+  if (JSON_unlikely(batch->count == batch->size))
+  {
+    size_t      size  = batch->size ? 2 * batch->size : 256;
+    JSON_Type** roots = realloc(batch->roots, size * sizeof(JSON_Type*));
+
+    if (JSON_unlikely(roots == NULL))
+      return 2;
+
+    batch->roots = roots;
+    batch->size  = size;
+  }
+
+  batch->roots[batch->count++] = root;
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Parse the records of a chunk in a document.
+ *
+ * In order, the records are kept in the batch, all in the document.
+ * Otherwise, every record is given to the callback as soon as it's
+ * parsed, then the document is reset.
+ *
+ * @return 0 on success, the failure of the parse, or the value of the
+ * callback.
+ */
+static int parse_chunk(Pool* pool, size_t i, JSON_Document* doc, Batch* batch)
+{
+  const char* p   = pool->buf + pool->bounds[i];
+  const char* end = pool->buf + pool->bounds[i + 1];
+
+  JSON_ResetDocument(doc);
+  batch->count = 0;
+
+  JSON_Document record = *doc;
+
+  while (p < end)
+  {
+    const char* eol = memchr(p, '\n', end - p);
+
+    if (eol == NULL)
+      eol = end;
+
+    JSON_Reader line;
+    JSON_Type*  root = NULL;
+
+    JSON_InitReader(&line, p, eol - p);
+
+    p = eol < end ? eol + 1 : end;
+
+    int retval = JSON_EngineParse(&root, &line, pool->hashFunc, pool->dictSize,
+                                  pool->listSize, &doc->alloc, doc->keys);
+
+    if (retval != 0)
+      return retval;
+
+    /*  Blank line  */
+    if (root == NULL)
+      continue;
+
+    if (pool->ordered)
+    {
+      if (JSON_unlikely(push_root(batch, root) != 0))
+        return 2;
+
+      continue;
+    }
+
+    record.root = root;
+    retval      = pool->callback(&record, pool->ctx);
+
+    JSON_ResetDocument(doc);
+
+    if (retval != 0)
+      return retval;
+  }
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Give the records of a batch to the callback.
+ */
+static int deliver(Pool* pool, const JSON_Document* doc, const Batch* batch)
+{
+  JSON_Document record = *doc;
+
+  for (size_t i = 0; i < batch->count; ++i)
+  {
+    record.root = batch->roots[i];
+
+    int retval = pool->callback(&record, pool->ctx);
+
+    if (retval != 0)
+      return retval;
+  }
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Parse chunks until there's none left, or a failure.
+ */
+static void* work(void* arg)
+{
+  Pool*          pool  = arg;
+  JSON_Document* doc   = JSON_MallocDocument();
+  Batch          batch = {NULL, 0, 0};
+
+  pthread_mutex_lock(&pool->lock);
+
+  if (JSON_unlikely(doc == NULL) && pool->status == 0)
+    pool->status = 2;
+
+  while (pool->status == 0 && pool->next < pool->chunks)
+  {
+    size_t i = pool->next++;
+
+    pthread_mutex_unlock(&pool->lock);
+
+    int retval = parse_chunk(pool, i, doc, &batch);
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->ordered)
+    {
+      while (pool->turn != i)
+        pthread_cond_wait(&pool->turned, &pool->lock);
+
+      /*  The records before a failure are delivered first  */
+      if (pool->status == 0)
+      {
+        pthread_mutex_unlock(&pool->lock);
+
+        int delivered = deliver(pool, doc, &batch);
+
+        pthread_mutex_lock(&pool->lock);
+
+        if (delivered != 0)
+          retval = delivered;
+      }
+
+      ++pool->turn;
+      pthread_cond_broadcast(&pool->turned);
+    }
+
+    if (retval != 0 && pool->status == 0)
+      pool->status = retval;
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+
+  free(batch.roots);
+  JSON_FreeDocument(doc);
+
+  return NULL;
+}
+
+
+
+
+int JSON_ParseRecordsParallel(JSON_Reader* reader,
+                              JSON_RecordFunc callback,
+                              void* ctx,
+                              size_t threads,
+                              int ordered,
+                              JSON_Hash hashFunc,
+                              size_t dictSize,
+                              size_t listSize)
+{
+  /*  A stream can't be cut ahead  */
+  if (reader->fd)
+  {
+    JSON_Document* doc = JSON_MallocDocument();
+
+    if (JSON_unlikely(doc == NULL))
+      return 2;
+
+    int retval = JSON_ParseRecords(doc, reader, callback, ctx, hashFunc,
+                                   dictSize, listSize);
+
+    JSON_FreeDocument(doc);
+
+    return retval;
+  }
+
+  if (threads == 0)
+  {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+    threads = online > 0 ? online : 1;
+  }
+
+  Pool pool =
+  {
+    .buf      = reader->cursor,
+    .callback = callback,
+    .ctx      = ctx,
+    .ordered  = ordered,
+    .hashFunc = hashFunc,
+    .dictSize = dictSize,
+    .listSize = listSize,
+  };
+
+  size_t* bounds = split(reader->cursor, reader->limit - reader->cursor, threads,
+                         &pool.chunks);
+
+  if (JSON_unlikely(bounds == NULL))
+    return 2;
+
+  pool.bounds    = bounds;
+  reader->cursor = reader->limit;
+
+  if (threads > pool.chunks)
+    threads = pool.chunks;
+
+  pthread_t* ids = threads > 1 ? malloc((threads - 1) * sizeof(pthread_t)) : NULL;
+  size_t     started = 0;
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.turned, NULL);
+
+  /*  The calling thread is one of them; fewer threads is only slower  */
+  while (ids && started < threads - 1
+         && pthread_create(&ids[started], NULL, work, &pool) == 0)
+    ++started;
+
+  work(&pool);
+
+  for (size_t i = 0; i < started; ++i)
+    pthread_join(ids[i], NULL);
+
+  pthread_cond_destroy(&pool.turned);
+  pthread_mutex_destroy(&pool.lock);
+
+  free(ids);
+  free(bounds);
+
+  return pool.status;
+}
@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sax.c
+ *
+ * @brief Event parser implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdio.h>
+#include <string.h>
+
+#include "commons.h"
+#include "parser.h"
+#include "sax.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The depth of containers before the stack is allocated. */
+#define SAX_STACK 64
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @brief The state of a parse.
+ */
+typedef struct Parser
+{
+  JSON_Reader*          reader;
+  const JSON_Handler*   handler;
+  const JSON_Allocator* alloc; /**< The allocator of the strings. */
+
+  JSON_YYSTYPE val;
+  JSON_YYLTYPE loc;
+
+  char*  stack; /**< The closing character of every open container. */
+  size_t depth; /**< The number of open containers. */
+  size_t size;  /**< The capacity of stack. */
+
+  char*  scratch; /**< The strings, if the handler has no allocator. */
+  size_t space;   /**< The capacity of scratch. */
+} Parser;
+
+
+
+
+/*=============================================================================+
+ |                                 Prototypes                                  |
+ +=============================================================================*/
+int JSON_yylex(JSON_YYSTYPE* val_p, JSON_YYLTYPE* loc_p, JSON_Reader* reader,
+               const JSON_Allocator* alloc);
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Allocator of the strings when the handler has none: every
+ * string is decoded in the same buffer.
+ */
+static void* scratch_alloc(void* ctx, size_t size)
+{
+  Parser* parser = ctx;
+
+  if (JSON_unlikely(size > parser->space))
+  {
+    char* scratch = realloc(parser->scratch, size);
+
+    if (JSON_unlikely(scratch == NULL))
+      return NULL;
+
+    parser->scratch = scratch;
+    parser->space   = size;
+  }
+
+  return parser->scratch;
+}
+
+
+
+
+static void* scratch_realloc(void* ctx, void* ptr, size_t old, size_t size)
+{
+  return scratch_alloc(ctx, size);
+}
+
+
+
+
+static void scratch_free(void* ctx, void* ptr)
+{
+  /*  Reused by the next string  */
+}
+
+
+
+
+static inline int lex(Parser* parser)
+{
+  return JSON_yylex(&parser->val, &parser->loc, parser->reader, parser->alloc);
+}
+
+
+
+
+/**
+ * @brief Open a container.
+ *
+ * @return 0 on success, 2 on failure.
+ */
+static int push(Parser* parser, char close, char* inline_stack)
+{
+  if (JSON_unlikely(parser->depth == parser->size))
+  {
+    size_t size  = 2 * parser->size;
+    char*  stack = malloc(size);
+
+    if (JSON_unlikely(stack == NULL))
+      return 2;
+
+    memcpy(stack, parser->stack, parser->depth);
+
+    if (parser->stack != inline_stack)
+      free(parser->stack);
+
+    parser->stack = stack;
+    parser->size  = size;
+  }
+
+  parser->stack[parser->depth++] = close;
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Reject a token.
+ *
+ * @return -1, for a syntax error.
+ */
+static int unexpected(Parser* parser, int token)
+{
+  /*  Nobody will own it  */
+  if (token == STR)
+    parser->alloc->free(parser->alloc->ctx, parser->val.str);
+
+  return -1;
+}
+
+
+
+
+/**
+ * @brief Read the label of an entry and its colon, and call the
+ * handler.
+ *
+ * @param [in,out] token The token of the label, already read, then
+ * the first token of the value.
+ *
+ * @return 0 on success, -1 on a syntax error, or the value of the
+ * callback.
+ */
+static int read_label(Parser* parser, int* token)
+{
+  const JSON_Handler* handler = parser->handler;
+
+  if (*token != STR)
+    return unexpected(parser, *token);
+
+  if (handler->key)
+  {
+    int retval = handler->key(handler->ctx, parser->val.str, strlen(parser->val.str));
+
+    if (JSON_unlikely(retval != 0))
+      return retval;
+  }
+  else
+  {
+    parser->alloc->free(parser->alloc->ctx, parser->val.str);
+  }
+
+  if ((*token = lex(parser)) != ':')
+    return unexpected(parser, *token);
+
+  *token = lex(parser);
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Call the handler for a scalar.
+ *
+ * @return The value of the callback, or -1 if the token isn't a
+ * scalar.
+ */
+static int scalar(Parser* parser, int token)
+{
+  const JSON_Handler* handler = parser->handler;
+
+  switch (token)
+  {
+  case STR:
+    if (handler->string)
+      return handler->string(handler->ctx, parser->val.str, strlen(parser->val.str));
+
+    parser->alloc->free(parser->alloc->ctx, parser->val.str);
+    return 0;
+  case NUM:
+    return handler->number ? handler->number(handler->ctx, &parser->val.number) : 0;
+  case BOOL:
+    return handler->boolean ? handler->boolean(handler->ctx, parser->val.bool) : 0;
+  default:
+    return -1;
+  }
+}
+
+
+
+
+/**
+ * @brief Call the handler for the end of the innermost container.
+ */
+static int close_container(Parser* parser)
+{
+  const JSON_Handler* handler = parser->handler;
+  int (*end) (void*) = parser->stack[--parser->depth] == '}' ? handler->end_dict
+                                                             : handler->end_list;
+
+  return end ? end(handler->ctx) : 0;
+}
+
+
+
+
+/**
+ * @brief Parse events until the end of the input.
+ *
+ * Every iteration starts with the first token of a value, then reads
+ * up to the first token of the next one.
+ *
+ * @return Same as JSON_ParseEvents(), with -1 for a syntax error.
+ */
+static int parse(Parser* parser, char* inline_stack)
+{
+  const JSON_Handler* handler = parser->handler;
+
+  int token = lex(parser);
+
+  /*  Empty  */
+  if (token == 0)
+    return 0;
+
+  /*  Like the parsers, a dict or a list at the top level  */
+  if (token != '{' && token != '[')
+    return unexpected(parser, token);
+
+  for (;;)
+  {
+    int retval = 0;
+
+    if (token == '{' || token == '[')
+    {
+      char close = token == '{' ? '}' : ']';
+      int (*start) (void*) = token == '{' ? handler->start_dict : handler->start_list;
+
+      if ((retval = push(parser, close, inline_stack)) != 0)
+        return retval;
+
+      if (start && (retval = start(handler->ctx)) != 0)
+        return retval;
+
+      token = lex(parser);
+
+      /*  And every dict and list has at least one element  */
+      if (token == close)
+        return unexpected(parser, token);
+
+      if (close == '}' && (retval = read_label(parser, &token)) != 0)
+        return retval;
+
+      /*  The first element starts with the token  */
+      continue;
+    }
+
+    if ((retval = scalar(parser, token)) != 0)
+      return retval;
+
+    /*  Then a comma or the end of containers  */
+    for (;;)
+    {
+      token = lex(parser);
+
+      if (parser->depth == 0)
+        return token == 0 ? 0 : unexpected(parser, token);
+
+      char close = parser->stack[parser->depth - 1];
+
+      if (token == ',')
+      {
+        token = lex(parser);
+
+        if (close == '}' && (retval = read_label(parser, &token)) != 0)
+          return retval;
+
+        break;
+      }
+
+      if (token != close)
+        return unexpected(parser, token);
+
+      if ((retval = close_container(parser)) != 0)
+        return retval;
+    }
+  }
+}
+
+
+
+
+int JSON_ParseEvents(JSON_Reader* reader, const JSON_Handler* handler)
+{
+  char inline_stack[SAX_STACK];
+
+  Parser parser =
+  {
+    .reader  = reader,
+    .handler = handler,
+    .alloc   = handler->alloc,
+    .loc     = {1, 1, 1, 1},
+    .stack   = inline_stack,
+    .size    = SAX_STACK,
+  };
+
+  JSON_Allocator scratch = {scratch_alloc, scratch_realloc, scratch_free, &parser};
+
+  if (parser.alloc == NULL)
+    parser.alloc = &scratch;
+
+  int retval = parse(&parser, inline_stack);
+
+  if (retval == -1)
+  {
+    fprintf(stderr, "syntax error at %d.%d-%d.%d\n",
+            parser.loc.first_line, parser.loc.last_line,
+            parser.loc.first_column, parser.loc.last_column);
+    retval = 1;
+  }
+
+  if (parser.stack != inline_stack)
+    free(parser.stack);
+
+  free(parser.scratch);
+
+  return retval;
+}
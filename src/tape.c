@@ -0,0 +1,713 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tape.c
+ *
+ * @brief JSON_Tape structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdio.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "commons.h"
+#include "parser.h"
+#include "tape.h"
+
+
+
+
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The initial capacities of the words, strings and numbers. */
+#define TAPE_MIN_WORDS   1024
+#define TAPE_MIN_STRINGS 4096
+#define TAPE_MIN_NUMBERS 256
+
+/** Make a word of a type and a payload. */
+#define WORD(type, payload) (((uint64_t)(type) << 56) | (uint64_t)(payload))
+
+
+
+
+/*=============================================================================+
+ |                                 Prototypes                                  |
+ +=============================================================================*/
+int JSON_yylex(JSON_YYSTYPE* val_p, JSON_YYLTYPE* loc_p, JSON_Reader* reader,
+               const JSON_Allocator* alloc);
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Grow a buffer to hold at least @b need elements.
+ *
+ * @return The buffer, maybe moved, or @b NULL on failure; the buffer is
+ * left untouched.
+ */
+static void* grow(void* buf, size_t* size, size_t need, size_t elem, size_t min)
+{
+  size_t n = *size ? *size : min;
+
+  while (n < need)
+    n *= 2;
+
+  buf = realloc(buf, n * elem);
+
+  if (JSON_likely(buf != NULL))
+    *size = n;
+
+  return buf;
+}
+
+
+
+
+/**
+ * @brief Append a word to a tape.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int push_word(JSON_Tape* tape, uint64_t word)
+{
+  if (JSON_unlikely(tape->count == tape->size))
+  {
+    /*  Indexes of words are 32 bits  */
+    if (tape->count >= UINT32_MAX)
+      return -1;
+
+    uint64_t* words = grow(tape->words, &tape->size, tape->count + 1,
+                           sizeof(uint64_t), TAPE_MIN_WORDS);
+
+    if (JSON_unlikely(words == NULL))
+      return -1;
+
+    tape->words = words;
+  }
+
+  tape->words[tape->count++] = word;
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Make room for a string of @b size bytes, NUL included.
+ *
+ * @return Where the characters go, after the length, or @b NULL on
+ * failure.
+ */
+static char* reserve_string(JSON_Tape* tape, size_t size)
+{
+  size_t need = tape->used + sizeof(uint32_t) + size;
+
+  if (JSON_unlikely(need > tape->space))
+  {
+    char* strings = grow(tape->strings, &tape->space, need, 1, TAPE_MIN_STRINGS);
+
+    if (JSON_unlikely(strings == NULL))
+      return NULL;
+
+    tape->strings = strings;
+  }
+
+  return tape->strings + tape->used + sizeof(uint32_t);
+}
+
+
+
+
+/**
+ * @brief Allocator of the lexer, decoding every string where it goes
+ * in the strings of the tape.
+ */
+static void* tape_alloc(void* ctx, size_t size)
+{
+  return reserve_string(ctx, size);
+}
+
+
+
+
+static void* tape_realloc(void* ctx, void* ptr, size_t old, size_t size)
+{
+  JSON_Tape* tape = ctx;
+
+  /*  Only the string being decoded can be given back  */
+  if (ptr && ptr != tape->strings + tape->used + sizeof(uint32_t))
+    return NULL;
+
+  return reserve_string(tape, size);
+}
+
+
+
+
+static void tape_free(void* ctx, void* ptr)
+{
+  /*  The space is taken by the next string  */
+}
+
+
+
+
+/**
+ * @brief Append a string, decoded by the lexer, to a tape.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int push_string(JSON_Tape* tape, JSON_Types type, const char* str)
+{
+  size_t len = strlen(str);
+  char*  at  = tape->strings ? tape->strings + tape->used + sizeof(uint32_t) : NULL;
+
+  if (JSON_unlikely(len > UINT32_MAX))
+    return -1;
+
+  /*  Decoded somewhere else, e.g in situ  */
+  if (JSON_unlikely(str != at))
+  {
+    at = reserve_string(tape, len + 1);
+
+    if (JSON_unlikely(at == NULL))
+      return -1;
+
+    memcpy(at, str, len + 1);
+  }
+
+  uint32_t length = len;
+
+  memcpy(at - sizeof(uint32_t), &length, sizeof(uint32_t));
+
+  if (JSON_unlikely(push_word(tape, WORD(type, at - tape->strings)) != 0))
+    return -1;
+
+  tape->used += sizeof(uint32_t) + len + 1;
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Append a number to a tape.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int push_number(JSON_Tape* tape, const JSON_Number* number)
+{
+  if (JSON_unlikely(tape->ncount == tape->nsize))
+  {
+    uint64_t* numbers = grow(tape->numbers, &tape->nsize, tape->ncount + 1,
+                             sizeof(uint64_t), TAPE_MIN_NUMBERS);
+
+    if (JSON_unlikely(numbers == NULL))
+      return -1;
+
+    tape->numbers = numbers;
+  }
+
+  /*  Every member of the union is 64 bits  */
+  tape->numbers[tape->ncount] = number->uinteger;
+
+  if (JSON_unlikely(push_word(tape, WORD(number->type, tape->ncount)) != 0))
+    return -1;
+
+  ++tape->ncount;
+
+  return 0;
+}
+
+
+
+
+/**
+ * @brief Read the label of the next entry of a dict, and its colon.
+ *
+ * @param [in] token The token of the label, already read.
+ *
+ * @return The first token of the value, or -1 on a syntax error and
+ * -2 on failure.
+ */
+static int read_label(JSON_Tape* tape, int token, JSON_Reader* reader,
+                      JSON_YYSTYPE* val_p, JSON_YYLTYPE* loc_p,
+                      const JSON_Allocator* alloc)
+{
+  if (token != STR)
+    return -1;
+
+  if (JSON_unlikely(push_string(tape, JSON_TAPE_LABEL, val_p->str) != 0))
+    return -2;
+
+  if (JSON_yylex(val_p, loc_p, reader, alloc) != ':')
+    return -1;
+
+  return JSON_yylex(val_p, loc_p, reader, alloc);
+}
+
+
+
+
+/**
+ * @brief Close the innermost container of a tape.
+ *
+ * While open, a container holds the index of its parent in its lower
+ * 32 bits, and its number of elements above.
+ *
+ * @return The index of the parent, or -1 on failure.
+ */
+static ssize_t close_container(JSON_Tape* tape, size_t open)
+{
+  uint64_t word   = tape->words[open];
+  size_t   parent = word & UINT32_MAX;
+
+  if (JSON_unlikely(push_word(tape, WORD(JSON_NONE, open)) != 0))
+    return -1;
+
+  tape->words[open] = WORD(JSON_TAPE_TYPE(word),
+                           (JSON_TAPE_PAYLOAD(word) & ~(uint64_t)UINT32_MAX)
+                           | tape->count);
+
+  return parent;
+}
+
+
+
+
+/**
+ * @brief Count one more element in the innermost container.
+ */
+static void count_element(JSON_Tape* tape, size_t open)
+{
+  if ((JSON_TAPE_PAYLOAD(tape->words[open]) >> 32) < JSON_TAPE_MAX_COUNT)
+    tape->words[open] += UINT64_C(1) << 32;
+}
+
+
+
+
+JSON_Tape* JSON_MallocTape(void)
+{
+  return calloc(1, sizeof(JSON_Tape));
+}
+
+
+
+
+void JSON_FreeTape(JSON_Tape* tape)
+{
+  if (tape)
+  {
+    free(tape->words);
+    free(tape->strings);
+    free(tape->numbers);
+    free(tape);
+  }
+}
+
+
+
+
+void JSON_ResetTape(JSON_Tape* tape)
+{
+  tape->count  = 0;
+  tape->used   = 0;
+  tape->ncount = 0;
+}
+
+
+
+
+int JSON_ParseTape(JSON_Tape* tape, JSON_Reader* reader)
+{
+  JSON_Allocator alloc = {tape_alloc, tape_realloc, tape_free, tape};
+
+  JSON_YYSTYPE val;
+  JSON_YYLTYPE loc = {1, 1, 1, 1};
+
+  /*  The innermost open container, 0 at the top level  */
+  size_t open = 0;
+
+  JSON_ResetTape(tape);
+
+  if (JSON_unlikely(push_word(tape, WORD(JSON_NONE, 0)) != 0))
+    return 2;
+
+  int token = JSON_yylex(&val, &loc, reader, &alloc);
+
+  /*  Empty  */
+  if (token == 0)
+  {
+    tape->words[0] = WORD(JSON_NONE, tape->count);
+    return 0;
+  }
+
+  /*  Like the parsers, a dict or a list at the top level  */
+  int failed = token == '{' || token == '[' ? 0 : -1;
+
+  while (failed == 0)
+  {
+    /*  A value starts with the token  */
+    switch (token)
+    {
+    case '{':
+    case '[':
+    {
+      JSON_Types type  = token == '{' ? JSON_DICT : JSON_LIST;
+      int        close = token == '{' ? '}' : ']';
+
+      if (JSON_unlikely(push_word(tape, WORD(type, open)) != 0))
+      {
+        failed = -2;
+        break;
+      }
+
+      open  = tape->count - 1;
+      token = JSON_yylex(&val, &loc, reader, &alloc);
+
+      /*  And it has at least one element  */
+      if (token == close)
+      {
+        failed = -1;
+        break;
+      }
+
+      count_element(tape, open);
+
+      if (type == JSON_DICT)
+      {
+        token = read_label(tape, token, reader, &val, &loc, &alloc);
+
+        if (token < 0)
+          failed = token;
+      }
+
+      /*  The first element starts with the token  */
+      if (failed == 0)
+        continue;
+
+      break;
+    }
+    case STR:
+      if (JSON_unlikely(push_string(tape, JSON_STRING, val.str) != 0))
+        failed = -2;
+      break;
+    case NUM:
+      if (JSON_unlikely(push_number(tape, &val.number) != 0))
+        failed = -2;
+      break;
+    case BOOL:
+      if (JSON_unlikely(push_word(tape, WORD(JSON_BOOLEAN, val.bool + 1)) != 0))
+        failed = -2;
+      break;
+    default:
+      failed = -1;
+      break;
+    }
+
+    /*  Then a comma or the end of containers  */
+    while (failed == 0)
+    {
+      token = JSON_yylex(&val, &loc, reader, &alloc);
+
+      if (open == 0)
+      {
+        if (token != 0)
+          failed = -1;
+
+        break;
+      }
+
+      JSON_Types type = JSON_TAPE_TYPE(tape->words[open]);
+
+      if (token == ',')
+      {
+        count_element(tape, open);
+
+        token = JSON_yylex(&val, &loc, reader, &alloc);
+
+        if (type == JSON_DICT)
+          token = read_label(tape, token, reader, &val, &loc, &alloc);
+
+        if (token < 0)
+          failed = token;
+
+        break;
+      }
+
+      if (token != (type == JSON_DICT ? '}' : ']'))
+      {
+        failed = -1;
+        break;
+      }
+
+      ssize_t parent = close_container(tape, open);
+
+      if (JSON_unlikely(parent < 0))
+        failed = -2;
+
+      open = parent;
+    }
+
+    /*  The top level value is done  */
+    if (failed == 0 && open == 0 && token == 0)
+      break;
+  }
+
+  if (failed == -1)
+  {
+    fprintf(stderr, "syntax error at %d.%d-%d.%d\n",
+            loc.first_line, loc.last_line, loc.first_column, loc.last_column);
+
+    JSON_ResetTape(tape);
+    return 1;
+  }
+
+  if (failed == -2)
+  {
+    JSON_ResetTape(tape);
+    return 2;
+  }
+
+  tape->words[0] = WORD(JSON_NONE, tape->count);
+
+  return 0;
+}
+
+
+
+
+int JSON_ParseTapeBuffer(JSON_Tape* tape, const char* buf, size_t len)
+{
+  JSON_Reader reader;
+
+  JSON_InitReader(&reader, buf, len);
+
+  return JSON_ParseTape(tape, &reader);
+}
+
+
+
+
+int JSON_ParseTapeFile(JSON_Tape* tape, const char* path)
+{
+  JSON_Reader reader;
+
+  if (JSON_OpenReader(&reader, path) != 0)
+  {
+    perror(path);
+    return -1;
+  }
+
+  int retval = JSON_ParseTape(tape, &reader);
+
+  JSON_CloseReader(&reader);
+
+  return retval;
+}
+
+
+
+
+size_t JSON_TapeRoot(const JSON_Tape* tape)
+{
+  return tape->count > 1 ? 1 : 0;
+}
+
+
+
+
+JSON_Types JSON_TapeType(const JSON_Tape* tape, size_t i)
+{
+  return JSON_TAPE_TYPE(tape->words[i]);
+}
+
+
+
+
+size_t JSON_TapeSkip(const JSON_Tape* tape, size_t i)
+{
+  uint64_t word = tape->words[i];
+
+  switch (JSON_TAPE_TYPE(word))
+  {
+  case JSON_DICT:
+  case JSON_LIST:
+    return word & UINT32_MAX;
+  default:
+    return i + 1;
+  }
+}
+
+
+
+
+size_t JSON_TapeSize(const JSON_Tape* tape, size_t i)
+{
+  uint64_t   word = tape->words[i];
+  JSON_Types type = JSON_TAPE_TYPE(word);
+
+  if (type == JSON_STRING || type == JSON_TAPE_LABEL)
+  {
+    uint32_t length;
+
+    memcpy(&length, tape->strings + JSON_TAPE_PAYLOAD(word) - sizeof(uint32_t),
+           sizeof(uint32_t));
+
+    return length;
+  }
+
+  if (type != JSON_DICT && type != JSON_LIST)
+    return 0;
+
+  size_t count = JSON_TAPE_PAYLOAD(word) >> 32;
+
+  if (JSON_likely(count < JSON_TAPE_MAX_COUNT))
+    return count;
+
+  count = 0;
+
+  for (size_t e = 0; (e = JSON_TapeNext(tape, i, e)) != 0; )
+    ++count;
+
+  return count;
+}
+
+
+
+
+size_t JSON_TapeNext(const JSON_Tape* tape, size_t i, size_t prev)
+{
+  size_t next = prev ? JSON_TapeSkip(tape, prev) : i + 1;
+
+  if (JSON_TAPE_TYPE(tape->words[next]) == JSON_NONE)
+    return 0;
+
+  /*  Skip the label  */
+  if (JSON_TAPE_TYPE(tape->words[i]) == JSON_DICT)
+    ++next;
+
+  return next;
+}
+
+
+
+
+size_t JSON_TapeGet(const JSON_Tape* tape, size_t i, const char* label)
+{
+  size_t len = strlen(label);
+
+  for (size_t e = 0; (e = JSON_TapeNext(tape, i, e)) != 0; )
+  {
+    if (JSON_TapeSize(tape, e - 1) == len
+        && memcmp(JSON_TapeString(tape, e - 1), label, len) == 0)
+      return e;
+  }
+
+  return 0;
+}
+
+
+
+
+size_t JSON_TapeAt(const JSON_Tape* tape, size_t i, size_t n)
+{
+  size_t e = 0;
+
+  while ((e = JSON_TapeNext(tape, i, e)) != 0 && n--)
+    continue;
+
+  return e;
+}
+
+
+
+
+const char* JSON_TapeLabel(const JSON_Tape* tape, size_t i)
+{
+  if (i < 2 || JSON_TAPE_TYPE(tape->words[i - 1]) != JSON_TAPE_LABEL)
+    return NULL;
+
+  return JSON_TapeString(tape, i - 1);
+}
+
+
+
+
+const char* JSON_TapeString(const JSON_Tape* tape, size_t i)
+{
+  return tape->strings + JSON_TAPE_PAYLOAD(tape->words[i]);
+}
+
+
+
+
+int64_t JSON_TapeInteger(const JSON_Tape* tape, size_t i)
+{
+  return (int64_t)tape->numbers[JSON_TAPE_PAYLOAD(tape->words[i])];
+}
+
+
+
+
+uint64_t JSON_TapeUnsigned(const JSON_Tape* tape, size_t i)
+{
+  return tape->numbers[JSON_TAPE_PAYLOAD(tape->words[i])];
+}
+
+
+
+
+double JSON_TapeNumber(const JSON_Tape* tape, size_t i)
+{
+  uint64_t bits = tape->numbers[JSON_TAPE_PAYLOAD(tape->words[i])];
+
+  switch (JSON_TAPE_TYPE(tape->words[i]))
+  {
+  case JSON_INTEGER:
+    return (int64_t)bits;
+  case JSON_UNSIGNED:
+    return bits;
+  default:
+  {
+    double num;
+
+    memcpy(&num, &bits, sizeof(double));
+
+    return num;
+  }
+  }
+}
+
+
+
+
+int JSON_TapeBool(const JSON_Tape* tape, size_t i)
+{
+  return (int)JSON_TAPE_PAYLOAD(tape->words[i]) - 1;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) Olivier Dion <olivier.dion@polymtl.ca>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tree.c
+ *
+ * @brief JSON_Tree structure implementations.
+ */
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <string.h>
+
+#include "commons.h"
+#include "tree.h"
+
+
+
+
+/*=============================================================================+
+ |                          Function Implementations                           |
+ +=============================================================================*/
+/**
+ * @brief Add a value to the innermost container, or make it the root.
+ *
+ * In a dict, the value takes the pending label, with its hash if it
+ * was interned. The last duplicate label wins.
+ *
+ * @return 0 on success, 2 on failure; the value is released.
+ */
+static int attach(JSON_Tree* tree, JSON_Type* value)
+{
+  if (JSON_unlikely(tree->depth == 0))
+  {
+    tree->root = value;
+    return 0;
+  }
+
+  JSON_Type* parent = tree->stack[tree->depth - 1];
+
+  if (parent->type == JSON_LIST)
+  {
+    if (JSON_likely(JSON_PushList(value, parent->list) == 0))
+      return 0;
+
+    JSON_FreeTypeWith(tree->alloc, value);
+    return 2;
+  }
+
+  value->label    = tree->label.str;
+  tree->label.str = NULL;
+
+  JSON_Type* ow;
+
+  /*  Without hashing the label again, see set_entry() in parser.y  */
+  if (tree->keys)
+  {
+    value->hash   = tree->label.hash;
+    value->length = tree->label.length;
+  }
+
+  if (tree->keys && parent->dict->hash == JSON_DefaultHash)
+    ow = JSON_SetDictHashedValue(parent->dict, value);
+  else
+    ow = JSON_SetDictValue(parent->dict, value);
+
+  if (JSON_unlikely(ow == value))
+  {
+    JSON_FreeTypeWith(tree->alloc, value);
+    return 2;
+  }
+
+  JSON_FreeTypeWith(tree->alloc, ow);
+
+  return 0;
+}
+
+
+
+
+void JSON_InitTree(JSON_Tree* tree,
+                   const JSON_Allocator* alloc,
+                   JSON_HashFunc hashFunc,
+                   size_t dictSize,
+                   size_t listSize,
+                   JSON_InternTable* keys)
+{
+  tree->root      = NULL;
+  tree->label.str = NULL;
+  tree->alloc     = alloc;
+  tree->keys      = keys;
+  tree->hashFunc  = hashFunc;
+  tree->dictSize  = dictSize;
+  tree->listSize  = listSize;
+  tree->stack     = tree->inline_stack;
+  tree->depth     = 0;
+  tree->size      = JSON_TREE_STACK;
+}
+
+
+
+
+int JSON_TreeOpen(JSON_Tree* tree, JSON_Types type)
+{
+  if (JSON_unlikely(tree->depth == tree->size))
+  {
+    size_t      size  = 2 * tree->size;
+    JSON_Type** stack = malloc(size * sizeof(JSON_Type*));
+
+    if (JSON_unlikely(stack == NULL))
+      return 2;
+
+    memcpy(stack, tree->stack, tree->depth * sizeof(JSON_Type*));
+
+    if (tree->stack != tree->inline_stack)
+      free(tree->stack);
+
+    tree->stack = stack;
+    tree->size  = size;
+  }
+
+  JSON_Type* value = JSON_MallocTypeWith(tree->alloc, NULL, type);
+
+  if (JSON_unlikely(value == NULL))
+    return 2;
+
+  if (type == JSON_DICT)
+    value->dict = JSON_MallocDictWith(tree->alloc, tree->dictSize, tree->hashFunc);
+  else
+    value->list = JSON_MallocListWith(tree->alloc, tree->listSize);
+
+  if (JSON_unlikely(type == JSON_DICT ? value->dict == NULL : value->list == NULL))
+  {
+    JSON_FreeTypeWith(tree->alloc, value);
+    return 2;
+  }
+
+  if (JSON_unlikely(attach(tree, value) != 0))
+    return 2;
+
+  tree->stack[tree->depth++] = value;
+
+  return 0;
+}
+
+
+
+
+void JSON_TreeLabel(JSON_Tree* tree, char* label, size_t length)
+{
+  tree->label.str    = label;
+  tree->label.length = length;
+
+  /*  The copy of a known label is the last allocation, give it back  */
+  if (tree->keys && JSON_InternString(tree->keys, &tree->label))
+    tree->alloc->free(tree->alloc->ctx, label);
+}
+
+
+
+
+int JSON_TreeString(JSON_Tree* tree, char* str)
+{
+  JSON_Type* value = JSON_MallocTypeWith(tree->alloc, NULL, JSON_STRING);
+
+  if (JSON_unlikely(value == NULL))
+  {
+    tree->alloc->free(tree->alloc->ctx, str);
+    return 2;
+  }
+
+  value->str = str;
+
+  return attach(tree, value);
+}
+
+
+
+
+int JSON_TreeNumber(JSON_Tree* tree, const JSON_Number* number)
+{
+  JSON_Type* value = JSON_MallocTypeWith(tree->alloc, NULL, number->type);
+
+  if (JSON_unlikely(value == NULL))
+    return 2;
+
+  /*  Every member of the union is 64 bits  */
+  value->uinteger = number->uinteger;
+
+  return attach(tree, value);
+}
+
+
+
+
+int JSON_TreeBool(JSON_Tree* tree, int bool)
+{
+  JSON_Type* value = JSON_MallocTypeWith(tree->alloc, NULL, JSON_BOOLEAN);
+
+  if (JSON_unlikely(value == NULL))
+    return 2;
+
+  value->bool = bool;
+
+  return attach(tree, value);
+}
+
+
+
+
+JSON_Type* JSON_ReleaseTree(JSON_Tree* tree, int failed)
+{
+  if (tree->stack != tree->inline_stack)
+    free(tree->stack);
+
+  tree->stack = tree->inline_stack;
+  tree->depth = 0;
+
+  if (JSON_unlikely(failed))
+  {
+    /*  Left by a failure between a label and its value  */
+    tree->alloc->free(tree->alloc->ctx, tree->label.str);
+    JSON_FreeTypeWith(tree->alloc, tree->root);
+
+    tree->label.str = NULL;
+    tree->root      = NULL;
+  }
+
+  return tree->root;
+}
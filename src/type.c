@@ -26,23 +26,64 @@
  +=============================================================================*/
 #include <string.h>
 
+#include "allocator.h"
+#include "commons.h"
 #include "error.h"
 #include "json.h"
 
 
 
 
+/*=============================================================================+
+ |                                   Macros                                    |
+ +=============================================================================*/
+/** The containers to free before the stack is allocated. */
+#define FREE_STACK 64
+
+
+
+
+/*=============================================================================+
+ |                                 Structures                                  |
+ +=============================================================================*/
+/**
+ * @brief The containers left to free.
+ */
+typedef struct Stack
+{
+  JSON_Type** values;
+  size_t      depth;
+  size_t      size;
+  JSON_Type** inline_values; /**< The values before growing. */
+} Stack;
+
+
+
+
 /*=============================================================================+
  |                             Function Prototypes                             |
  +=============================================================================*/
 JSON_Type* JSON_MallocType(const char* label, JSON_Types type_)
 {
-  JSON_Type* type = calloc(1, sizeof(JSON_Type));
+  return JSON_MallocTypeWith(NULL, label, type_);
+}
+
+
+
+
+JSON_Type* JSON_MallocTypeWith(const JSON_Allocator* alloc,
+                               const char* label,
+                               JSON_Types type_)
+{
+  if (alloc == NULL)
+    alloc = &JSON_DefaultAllocator;
+
+  JSON_Type* type = JSON_AllocZero(alloc, sizeof(JSON_Type));
 
   if (type)
   {
     if (label)
-      type->label = strdup(label);
+      type->label = JSON_AllocString(alloc, label);
     else
       type->label = NULL;
 
@@ -57,55 +98,113 @@ JSON_Type* JSON_MallocType(const char* label, JSON_Types type_)
 
 void JSON_FreeType(JSON_Type* type)
 {
-  JSON_List* stack = JSON_MallocList(1024);
-  JSON_PushList(type, stack);
+  JSON_FreeTypeWith(NULL, type);
+}
+
+
+
+
+/**
+ * @brief Free a value, but not the dict or the list it holds.
+ */
+static void free_value(const JSON_Allocator* alloc, JSON_Type* type)
+{
+  if (type->type == JSON_STRING)
+    alloc->free(alloc->ctx, type->str);
+
+  alloc->free(alloc->ctx, type->label);
+  alloc->free(alloc->ctx, type);
+}
+
+
+
+
+/**
+ * @brief Free a scalar now, or push a container to free it later.
+ */
+static void free_later(const JSON_Allocator* alloc, Stack* stack, JSON_Type* type)
+{
+  if (type->type != JSON_DICT && type->type != JSON_LIST)
+  {
+    free_value(alloc, type);
+    return;
+  }
+
+  if (JSON_unlikely(stack->depth == stack->size))
+  {
+    size_t      size   = 2 * stack->size;
+    JSON_Type** values = alloc->alloc(alloc->ctx, size * sizeof(JSON_Type*));
+
+    /*  Out of memory, this one is freed on the call stack  */
+    if (JSON_unlikely(values == NULL))
+    {
+      JSON_FreeTypeWith(alloc, type);
+      return;
+    }
+
+    memcpy(values, stack->values, stack->depth * sizeof(JSON_Type*));
+
+    if (stack->values != stack->inline_values)
+      alloc->free(alloc->ctx, stack->values);
+
+    stack->values = values;
+    stack->size   = size;
+  }
+
+  stack->values[stack->depth++] = type;
+}
+
+
+
+
+void JSON_FreeTypeWith(const JSON_Allocator* alloc, JSON_Type* type)
+{
+  if (type == NULL)
+    return;
+
+  if (alloc == NULL)
+    alloc = &JSON_DefaultAllocator;
 
-  JSON_Type*  p;
-  JSON_Type* stack_p;
+  JSON_Type* inline_values[FREE_STACK];
+  Stack      stack = {inline_values, 0, FREE_STACK, inline_values};
 
-  while ((stack_p = JSON_PopList(stack)) != NULL)
+  /*  A scalar is freed without stack  */
+  free_later(alloc, &stack, type);
+
+  while (stack.depth > 0)
   {
-    switch (stack_p->type)
+    JSON_Type* value = stack.values[--stack.depth];
+
+    /*  The dict or the list is NULL if its allocation failed  */
+    if (value->type == JSON_DICT && value->dict)
     {
-    case JSON_STRING:
-      free(stack_p->str);
-      break;
-    case JSON_DICT:
-
-      for (size_t i = 0; i < stack_p->dict->size; ++i)
-      {
-        p = stack_p->dict->buckets[i];
-
-        while (p)
-        {
-          JSON_PushList(p, stack);
-          p = p->next;
-        }
-      }
-
-      free(stack_p->dict->buckets);
-      free(stack_p->dict);
-
-      break;
-    case JSON_LIST:
-
-      for (size_t i = 0; i < stack_p->list->index; ++i)
-      {
-        JSON_PushList(stack_p->list->elements[i], stack);
-      }
-
-      free(stack_p->list->elements);
-      free(stack_p->list);
-
-      break;
-    default:
-      break;
+      JSON_Dict* dict = value->dict;
+      JSON_Type* p    = NULL;
+      size_t     i    = 0;
+
+      while ((p = JSON_NextDictValue(dict, &i)) != NULL)
+        free_later(alloc, &stack, p);
+
+      dict->alloc->free(dict->alloc->ctx, dict->entries);
+      dict->alloc->free(dict->alloc->ctx, dict->index);
+      dict->alloc->free(dict->alloc->ctx, dict->links);
+      dict->alloc->free(dict->alloc->ctx, dict->ctrl);
+      dict->alloc->free(dict->alloc->ctx, dict);
+    }
+    else if (value->type == JSON_LIST && value->list)
+    {
+      JSON_List* list = value->list;
+
+      for (size_t i = 0; i < list->index; ++i)
+        free_later(alloc, &stack, list->elements[i]);
+
+      list->alloc->free(list->alloc->ctx, list->elements);
+      list->alloc->free(list->alloc->ctx, list);
     }
 
-    free(stack_p->label);
-    free(stack_p);
+    free_value(alloc, value);
   }
 
-  free(stack->elements);
-  free(stack);
+  if (stack.values != inline_values)
+    alloc->free(alloc->ctx, stack.values);
 }
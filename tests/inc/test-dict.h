@@ -0,0 +1,283 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test-dict.h
+ *
+ * @brief All Tests for JSON_Dict structure.
+ */
+
+#ifndef _JSON_TEST_DICT_H
+#define _JSON_TEST_DICT_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+#include "utils.h"
+#include "test-struct.h"
+
+
+
+
+/*=============================================================================+
+ |                                    Tests                                    |
+ +=============================================================================*/
+static size_t Test_DictHash(JSON_HashKey key)
+{
+  size_t hash = 5381;
+
+  while (*key)
+    hash = 33 * hash + (unsigned char)*key++;
+
+  return hash;
+}
+
+
+
+/**
+ * @brief Fill a dict with many keys, then look them up and remove some.
+ *
+ * @return Non zero if the dict behaved.
+ */
+static int Test_FillDict(JSON_DictEngine engine)
+{
+  static const size_t N = 10000;
+
+  char key[32];
+  int  ok = 1;
+
+  dict* d = JSON_MallocDictEngine(NULL, 1, Test_DictHash, engine);
+
+  if (d == NULL)
+    return 0;
+
+  for (size_t i=0; i < N; ++i)
+  {
+    sprintf(key, "key%zu", i);
+
+    tinteger(x, i);
+
+    x->label = strdup(key);
+
+    if (JSON_SetDictValue(d, x) != NULL)
+      ok = 0;
+  }
+
+  if (d->count != N)
+    ok = 0;
+
+  for (size_t i=0; i < N; ++i)
+  {
+    sprintf(key, "key%zu", i);
+
+    const type* x = JSON_GetDictValue(key, d);
+
+    if (x == NULL || x->integer != (int64_t)i)
+      ok = 0;
+    else if (x->hash != Test_DictHash(key) || x->length != strlen(key))
+      ok = 0;
+  }
+
+  /*  Remove every other key, then check the others are still there  */
+  for (size_t i=0; i < N; i += 2)
+  {
+    sprintf(key, "key%zu", i);
+
+    if (JSON_FreeDictValue(key, d) != 0 || JSON_GetDictValue(key, d) != NULL)
+      ok = 0;
+  }
+
+  for (size_t i=1; i < N; i += 2)
+  {
+    sprintf(key, "key%zu", i);
+
+    if (JSON_GetDictValue(key, d) == NULL)
+      ok = 0;
+  }
+
+  size_t     count = 0;
+  size_t     it    = 0;
+  JSON_Type* p     = NULL;
+
+  while ((p = JSON_NextDictValue(d, &it)) != NULL)
+    ++count;
+
+  if (d->count != N / 2 || count != N / 2)
+    ok = 0;
+
+  JSON_FreeDict(d);
+
+  return ok;
+}
+
+
+
+void* Test_GrowDict(void* arg)
+{
+  INIT_WORKER(val, "GrowDict", "\0", 1);
+
+  dict* d = JSON_MallocDict(1, Test_DictHash);
+
+  if (d == NULL || !d->flat)
+    val->ok = 0;
+
+  /*  Flat up to JSON_DICT_FLAT_MAX entries, then a table  */
+  for (int i=0; d && i <= JSON_DICT_FLAT_MAX; ++i)
+  {
+    char key[16];
+
+    sprintf(key, "%d", i);
+
+    tinteger(x, i);
+
+    x->label = strdup(key);
+
+    JSON_SetDictValue(d, x);
+
+    if (d->flat != (i < JSON_DICT_FLAT_MAX) || JSON_GetDictValue("0", d) == NULL)
+      val->ok = 0;
+  }
+
+  JSON_FreeDict(d);
+
+  d = JSON_MallocDict(JSON_DICT_FLAT_MAX + 1, Test_DictHash);
+
+  if (d == NULL || d->flat || d->size < JSON_DICT_MIN_SIZE)
+    val->ok = 0;
+
+  JSON_FreeDict(d);
+
+  val->ok = val->ok && Test_FillDict(JSON_DICT_CHAINED);
+
+  return val;
+}
+
+
+
+void* Test_OpenDict(void* arg)
+{
+  INIT_WORKER(val, "OpenDict", "\0", 1);
+
+  val->ok = Test_FillDict(JSON_DICT_OPEN);
+
+  return val;
+}
+
+
+
+/**
+ * @brief Check that a dict iterates in insertion order, across
+ * removals and growth.
+ *
+ * @return Non zero if the order was kept.
+ */
+static int Test_OrderEngine(JSON_DictEngine engine)
+{
+  static const int N = 1001;
+
+  char key[32];
+  int  ok = 1;
+
+  dict* d = JSON_MallocDictEngine(NULL, 1, NULL, engine);
+
+  if (d == NULL)
+    return 0;
+
+  for (int i=0; i < N; ++i)
+  {
+    sprintf(key, "%d", N - i);
+
+    tinteger(x, N - i);
+
+    x->label = strdup(key);
+    JSON_SetDictValue(d, x);
+
+    /*  Remove every third key as soon as the next one is in  */
+    if (i % 3 == 1)
+    {
+      sprintf(key, "%d", N - i + 1);
+      JSON_FreeDictValue(key, d);
+    }
+  }
+
+  size_t     it   = 0;
+  JSON_Type* p    = NULL;
+  int64_t    last = N + 1;
+
+  while ((p = JSON_NextDictValue(d, &it)) != NULL)
+  {
+    if (p->integer >= last || (N - p->integer) % 3 == 0)
+      ok = 0;
+
+    last = p->integer;
+  }
+
+  JSON_FreeDict(d);
+
+  return ok;
+}
+
+
+
+void* Test_OrderDict(void* arg)
+{
+  INIT_WORKER(val, "OrderDict", "\0", 1);
+
+  val->ok = Test_OrderEngine(JSON_DICT_CHAINED) && Test_OrderEngine(JSON_DICT_OPEN);
+
+  return val;
+}
+
+
+
+void* Test_DefaultHash(void* arg)
+{
+  INIT_WORKER(val, "DefaultHash", "\0", 1);
+
+  /*  Anagrams collided with the byte sum  */
+  if (JSON_DefaultHash("ab") == JSON_DefaultHash("ba"))
+    val->ok = 0;
+
+  if (JSON_DefaultHash("") == JSON_DefaultHash("a"))
+    val->ok = 0;
+
+  dict* d = JSON_MallocDict(1, NULL);
+
+  if (d == NULL || d->hash != JSON_DefaultHash)
+  {
+    val->ok = 0;
+  }
+  else
+  {
+    tinteger(x, 1);
+
+    x->label = strdup("a key longer than sixteen bytes");
+
+    JSON_SetDictValue(d, x);
+
+    if (JSON_GetDictValue("a key longer than sixteen bytes", d) != x)
+      val->ok = 0;
+  }
+
+  JSON_FreeDict(d);
+
+  return val;
+}
+#endif // _JSON_TEST_DICT_H
@@ -80,7 +80,7 @@ void* Test_InsertList(void* arg)
   lprint(l,fd);
 
   /*  Insert in middle  */
-  linsert(B,2,l);
+  linsert(C,2,l);
   lprint(l,fd);
 
   /*  Check final list  [A,1,C,2,3,B] */
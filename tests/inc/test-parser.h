@@ -0,0 +1,1444 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test-parser.h
+ *
+ * @brief All Tests for the parser.
+ */
+
+#ifndef _JSON_TEST_PARSER_H
+#define _JSON_TEST_PARSER_H
+
+/*=============================================================================+
+ |                                  Includes                                   |
+ +=============================================================================*/
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cursor.h"
+#include "descent.h"
+#include "document.h"
+#include "index.h"
+#include "json.h"
+#include "parallel.h"
+#include "push.h"
+#include "records.h"
+#include "sax.h"
+#include "tape.h"
+#include "utils.h"
+#include "test-struct.h"
+
+
+
+
+/*=============================================================================+
+ |                                    Tests                                    |
+ +=============================================================================*/
+/**
+ * @brief Print a tree, or only the status of its parse.
+ */
+static char* Test_PrintParsed(int retval, type* t)
+{
+  char*  out = NULL;
+  size_t len = 0;
+  FILE*  fd  = open_memstream(&out, &len);
+
+  fprintf(fd, "%d ", retval);
+
+  if (t)
+    JSON_PrintType(t, fd);
+
+  fclose(fd);
+  JSON_FreeType(t);
+
+  return out;
+}
+
+
+
+void* Test_ParseStream(void* arg)
+{
+  const size_t block = JSON_READER_BLOCK;
+  const size_t large = 3 * block;
+
+  /*  The value and how many of its bytes are in the first block: the
+      backslash of an escape is its last byte, and the last string
+      is larger than a block, which grows it twice  */
+  static const struct
+  {
+    const char* value;
+    size_t      before;
+    int         status;
+  } cases[] =
+  {
+    {"\"abcdefgh\"",         3, 0},
+    {"\"ab\\\"c\\u00e9\"", 4, 0},
+    {"-12345.5e-1",         5, 0},
+    {"true",                2, 0},
+    {"null",                1, 0},
+    {"tru",                 2, 1},
+    {NULL,                  10, 0},
+  };
+
+  INIT_WORKER(val, "ParseStream", "\0", 1);
+
+  char* buf = malloc(block + large + 16);
+
+  if (buf == NULL)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+  {
+    size_t len = 0;
+
+    buf[len++] = '[';
+
+    while (len < block - cases[i].before)
+      buf[len++] = ' ';
+
+    if (cases[i].value)
+      len += sprintf(buf + len, "%s]", cases[i].value);
+    else
+    {
+      buf[len++] = '"';
+      memset(buf + len, 'x', large);
+      len += large;
+      len += sprintf(buf + len, "\"]");
+    }
+
+    /*  The same tree as in place, without blocks  */
+    FILE* in = fmemopen(buf, len, "r");
+    type* t  = NULL;
+
+    if (in == NULL)
+    {
+      val->ok = 0;
+      break;
+    }
+
+    int   retval   = JSON_parse(&t, in, NULL, 4, 2);
+    char* streamed = Test_PrintParsed(retval, t);
+
+    if (retval != cases[i].status)
+      val->ok = 0;
+
+    t      = NULL;
+    retval = JSON_ParseBuffer(&t, buf, len, NULL, 4, 2);
+
+    char* in_place = Test_PrintParsed(retval, t);
+
+    if (strcmp(streamed, in_place) != 0)
+      val->ok = 0;
+
+    free(streamed);
+    free(in_place);
+    fclose(in);
+  }
+
+  free(buf);
+
+  return val;
+}
+
+
+
+void* Test_ParseEscapes(void* arg)
+{
+  static char data[] = "[\"a\\\"b\", \"\\u00e9\\ud83d\\ude00\", \"x\\\\y\\n\\/\"]";
+
+  static const char* expected[] =
+  {
+    "a\"b",
+    "\xc3\xa9\xf0\x9f\x98\x80",
+    "x\\y\n/"
+  };
+
+  type* t = NULL;
+
+  INIT_WORKER(val, "ParseEscapes", "\0", 1);
+
+  if (sparse(&t, data, NULL))
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  for (size_t i=0; i < 3; ++i)
+  {
+    const type* s = JSON_AtList(t->list, i);
+
+    if (s == NULL || s->type != JSON_STRING || strcmp(s->str, expected[i]))
+      val->ok = 0;
+  }
+
+  tfree(t);
+
+  /*  Lone surrogate  */
+  static char bad[] = "[\"\\udc00\"]";
+
+  t = NULL;
+
+  if (sparse(&t, bad, NULL) == 0)
+  {
+    val->ok = 0;
+    tfree(t);
+  }
+
+  return val;
+}
+
+
+
+void* Test_ParseNumbers(void* arg)
+{
+  static char data[] = "[0.0, -0.5, 1e3, 2.2250738585072014e-308, 9007199254740993.0]";
+
+  static const double expected[] =
+  {
+    0, -0.5, 1000, 2.2250738585072014e-308, 9007199254740992.0
+  };
+
+  static char* invalid[] = {"[01]", "[1.]", "[.5]", "[1e]", "[+1]", "[-]"};
+
+  type* t = NULL;
+
+  INIT_WORKER(val, "ParseNumbers", "\0", 1);
+
+  if (sparse(&t, data, NULL))
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  for (size_t i=0; i < 5; ++i)
+  {
+    const type* x = JSON_AtList(t->list, i);
+
+    if (x == NULL || x->type != JSON_NUMBER || x->num != expected[i])
+      val->ok = 0;
+  }
+
+  tfree(t);
+
+  for (size_t i=0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+  {
+    t = NULL;
+
+    if (sparse(&t, invalid[i], NULL) == 0)
+    {
+      val->ok = 0;
+      tfree(t);
+    }
+  }
+
+  return val;
+}
+
+
+
+void* Test_ParseIntegers(void* arg)
+{
+  static char data[] = "[0, -9223372036854775808, 18446744073709551615, 18446744073709551616, -0]";
+
+  static const JSON_Types expected[] =
+  {
+    JSON_INTEGER, JSON_INTEGER, JSON_UNSIGNED, JSON_NUMBER, JSON_NUMBER
+  };
+
+  type* t = NULL;
+
+  INIT_WORKER(val, "ParseIntegers", "\0", 1);
+
+  if (sparse(&t, data, NULL))
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  for (size_t i=0; i < 5; ++i)
+  {
+    const type* x = JSON_AtList(t->list, i);
+
+    if (x == NULL || x->type != expected[i])
+      val->ok = 0;
+  }
+
+  if (val->ok)
+  {
+    const type* min = JSON_AtList(t->list, 1);
+    const type* max = JSON_AtList(t->list, 2);
+
+    if (min->integer != INT64_MIN || max->uinteger != UINT64_MAX)
+      val->ok = 0;
+
+    /*  Printed back exactly  */
+    char  buf[32] = {0};
+    FILE* fd      = tmpfile();
+
+    if (fd)
+    {
+      JSON_PrintType(min, fd);
+      rewind(fd);
+
+      if (fgets(buf, sizeof(buf), fd) == NULL || strcmp(buf, "-9223372036854775808"))
+        val->ok = 0;
+
+      fclose(fd);
+    }
+  }
+
+  tfree(t);
+
+  return val;
+}
+
+
+
+static size_t Test_Hash(JSON_HashKey key)
+{
+  size_t hash = 0;
+
+  while (*key)
+    hash = 31 * hash + (unsigned char)*key++;
+
+  return hash;
+}
+
+
+
+/**
+ * @brief Parse a string with an engine, with an index built by a kernel
+ * or without any.
+ *
+ * @return The status of the parse, or -1 if the kernel isn't supported.
+ */
+static int Test_ParseIndexed(const char* data, const char* kernel, int descent)
+{
+  JSON_Index* index = NULL;
+  JSON_Reader reader;
+  type*       t = NULL;
+
+  JSON_InitReader(&reader, data, strlen(data));
+
+  if (kernel)
+  {
+    if ((index = JSON_MallocIndexKernel(data, strlen(data), kernel)) == NULL)
+      return -1;
+
+    JSON_IndexReader(&reader, index);
+  }
+
+  int retval = descent ? JSON_DescentParse(&t, &reader, NULL, 4, 2, &JSON_DefaultAllocator, NULL)
+                       : JSON_yyparse(&t, &reader, NULL, 4, 2, &JSON_DefaultAllocator, NULL);
+
+  JSON_FreeType(t);
+  JSON_FreeIndex(index);
+
+  return retval;
+}
+
+
+
+void* Test_IndexParse(void* arg)
+{
+  static const char* data[] =
+  {
+    "[1, -2.5e3, true, null, \"a\\\"b\", {\"k\": false}]",
+    "{\"padding over a block of 64 bytes\": [1 , 2 ,\n3], \"x\": \"\\\\\"}",
+    "[1@]",
+    "{\"a\":null\xc3\xa9}",
+    "[truex, 1]",
+    "[1\"a\"]",
+    "[1.5.5]",
+    "{\"a\": [1 2]}",
+  };
+
+  static const char* kernels[] = {"scalar", "sse4.2", "avx2"};
+
+  INIT_WORKER(val, "IndexParse", "\0", 1);
+
+  /*  The first two are valid  */
+  for (size_t i = 0; i < sizeof(data) / sizeof(data[0]); ++i)
+  {
+    for (int descent = 0; descent < 2; ++descent)
+    {
+      int expected = Test_ParseIndexed(data[i], NULL, descent);
+
+      if (expected != (i < 2 ? 0 : 1))
+        val->ok = 0;
+
+      for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+      {
+        int retval = Test_ParseIndexed(data[i], kernels[k], descent);
+
+        /*  Unless the CPU lacks the kernel  */
+        if (retval != -1 && retval != expected)
+          val->ok = 0;
+      }
+    }
+  }
+
+  return val;
+}
+
+
+
+void* Test_ParseFile(void* arg)
+{
+  static const char data[] = "{\"a\": [1, \"x\"]}";
+
+  char        path[] = "/tmp/json-test-XXXXXX";
+  char        proc[64];
+  int         fds[2];
+  JSON_Reader reader;
+  type*       t = NULL;
+
+  INIT_WORKER(val, "ParseFile", "\0", 1);
+
+  int fd = mkstemp(path);
+
+  if (fd < 0 || write(fd, data, strlen(data)) != (ssize_t)strlen(data))
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  /*  A regular file is mapped  */
+  if (JSON_OpenReader(&reader, path) != 0 || reader.fd != NULL
+      || JSON_ParseReader(&t, &reader, NULL, 4, 2) != 0
+      || JSON_GetDictValue("a", t->dict)->list->index != 2)
+    val->ok = 0;
+
+  JSON_CloseReader(&reader);
+  JSON_FreeType(t);
+  t = NULL;
+
+  /*  An empty one has no value  */
+  if (ftruncate(fd, 0) != 0 || JSON_ParseFile(&t, path, NULL, 4, 2) != 0 || t != NULL)
+    val->ok = 0;
+
+  close(fd);
+  unlink(path);
+
+  /*  A missing one can't be opened  */
+  if (JSON_ParseFile(&t, path, NULL, 4, 2) != -1 || errno != ENOENT)
+    val->ok = 0;
+
+  /*  A pipe can't be mapped, it's read as a stream  */
+  if (pipe(fds) != 0 || write(fds[1], data, strlen(data)) != (ssize_t)strlen(data))
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  close(fds[1]);
+  snprintf(proc, sizeof(proc), "/proc/self/fd/%d", fds[0]);
+
+  if (JSON_OpenReader(&reader, proc) != 0 || reader.fd == NULL
+      || JSON_ParseReader(&t, &reader, NULL, 4, 2) != 0
+      || strcmp(JSON_GetDictValue("a", t->dict)->list->elements[1]->str, "x") != 0)
+    val->ok = 0;
+
+  JSON_CloseReader(&reader);
+  JSON_FreeType(t);
+  close(fds[0]);
+
+  return val;
+}
+
+
+
+void* Test_ParseDocument(void* arg)
+{
+  static char data[] = "{\"a\": [1, 2, 3, 4, 5, \"x\"], \"b\": {\"c\": true}, \"a\": \"y\"}";
+
+  INIT_WORKER(val, "ParseDocument", "\0", 1);
+
+  JSON_Document* doc = JSON_MallocDocument();
+
+  if (doc == NULL)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  /*  The memory of the first parse is reused by the second one  */
+  for (int i=0; i < 2; ++i)
+  {
+    if (JSON_ParseDocumentBuffer(doc, data, strlen(data), Test_Hash, 4, 2))
+    {
+      val->ok = 0;
+      break;
+    }
+
+    const type* a = JSON_GetDictValue("a", doc->root->dict);
+    const type* b = JSON_GetDictValue("b", doc->root->dict);
+
+    if (a == NULL || a->type != JSON_STRING || strcmp(a->str, "y"))
+      val->ok = 0;
+
+    if (b == NULL || b->type != JSON_DICT ||
+        JSON_GetDictValue("c", b->dict) == NULL)
+      val->ok = 0;
+
+    if (doc->arena->count != 1)
+      val->ok = 0;
+  }
+
+  JSON_FreeDocument(doc);
+
+  return val;
+}
+
+
+
+void* Test_ArenaReuse(void* arg)
+{
+  static const size_t sizes[] = {100000, 9, 16, 1, 8, 100000};
+
+  INIT_WORKER(val, "ArenaReuse", "\0", 1);
+
+  JSON_Arena* arena = JSON_MallocArena(0);
+
+  if (arena == NULL)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  /*  A chunk larger than JSON_ARENA_CHUNK, for an odd size  */
+  if (JSON_ArenaAlloc(arena, JSON_ARENA_CHUNK + 34465) == NULL)
+    val->ok = 0;
+
+  /*  Reused after a reset, up to its end  */
+  JSON_ResetArena(arena);
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); ++i)
+  {
+    char*       p     = JSON_ArenaAlloc(arena, sizes[i]);
+    JSON_Chunk* chunk = arena->current;
+
+    if (p == NULL || (uintptr_t)p % JSON_ARENA_ALIGN != 0
+        || p < chunk->data || p + sizes[i] > chunk->data + chunk->size)
+    {
+      val->ok = 0;
+      break;
+    }
+
+    memset(p, 0, sizes[i]);
+  }
+
+  JSON_FreeArena(arena);
+
+  return val;
+}
+
+
+
+void* Test_InternKeys(void* arg)
+{
+  static char data[] = "[{\"id\": 1, \"name\": \"a\"}, {\"name\": \"b\", \"id\": 2}]";
+
+  INIT_WORKER(val, "InternKeys", "\0", 1);
+
+  JSON_Document* doc = JSON_MallocDocument();
+
+  if (doc == NULL || JSON_ParseDocumentBuffer(doc, data, strlen(data), NULL, 4, 2))
+  {
+    JSON_FreeDocument(doc);
+    val->ok = 0;
+    return val;
+  }
+
+  const dict* x = doc->root->list->elements[0]->dict;
+  const dict* y = doc->root->list->elements[1]->dict;
+
+  const type* id   = JSON_GetDictValue("id", y);
+  const type* name = JSON_GetDictValue("name", y);
+
+  /*  Same labels, same strings  */
+  if (id == NULL || id->integer != 2 || name == NULL
+      || id->label != x->entries[0]->label || name->label != x->entries[1]->label)
+    val->ok = 0;
+
+  if (doc->keys->count != 2)
+    val->ok = 0;
+
+  JSON_FreeDocument(doc);
+
+  return val;
+}
+
+
+
+void* Test_ParseInSitu(void* arg)
+{
+  char data[] = "{\"a\": \"plain\", \"b\": \"e\\u00e9\\n\", \"a\": [\"x\"]}";
+  char* end   = data + sizeof(data);
+
+  INIT_WORKER(val, "ParseInSitu", "\0", 1);
+
+  JSON_Document* doc = JSON_MallocDocument();
+
+  if (doc == NULL || JSON_ParseDocumentInSitu(doc, data, strlen(data), NULL, 4, 2))
+  {
+    JSON_FreeDocument(doc);
+    val->ok = 0;
+    return val;
+  }
+
+  const type* a = JSON_GetDictValue("a", doc->root->dict);
+  const type* b = JSON_GetDictValue("b", doc->root->dict);
+
+  if (a == NULL || b == NULL || strcmp(b->str, "e\xc3\xa9\n") != 0
+      || strcmp(a->list->elements[0]->str, "x") != 0)
+    val->ok = 0;
+
+  /*  Nothing copied  */
+  else if (b->str < data || b->str >= end || a->label < data || a->label >= end)
+    val->ok = 0;
+
+  JSON_FreeDocument(doc);
+
+  return val;
+}
+
+
+
+void* Test_ParseRecords(void* arg)
+{
+  static char data[] = "{\"a\": 1}\n\n[1, 2]\r\n{\"a\": }\n{\"b\": true}";
+
+  INIT_WORKER(val, "ParseRecords", "\0", 1);
+
+  JSON_Document* doc = JSON_MallocDocument();
+  FILE*          in  = fmemopen(data, strlen(data), "r");
+  JSON_Reader*   reader = in ? JSON_MallocReader(in) : NULL;
+
+  /*  The blank line is skipped, and the invalid one too  */
+  if (doc == NULL || reader == NULL
+      || JSON_NextRecord(doc, reader, NULL, 4, 2) != 0 || doc->root->type != JSON_DICT
+      || JSON_NextRecord(doc, reader, NULL, 4, 2) != 0 || doc->root->list->index != 2
+      || JSON_NextRecord(doc, reader, NULL, 4, 2) != 1
+      || JSON_NextRecord(doc, reader, NULL, 4, 2) != 0
+      || JSON_GetDictValue("b", doc->root->dict)->bool != 1
+      || JSON_NextRecord(doc, reader, NULL, 4, 2) != -1)
+    val->ok = 0;
+
+  /*  A document holds a single value  */
+  type* twice = NULL;
+
+  if (JSON_ParseBuffer(&twice, "{\"a\": 1} {\"b\": 2}", 16, NULL, 4, 2) != 1)
+    val->ok = 0;
+
+  JSON_FreeType(twice);
+
+  JSON_FreeReader(reader);
+
+  if (in)
+    fclose(in);
+
+  JSON_FreeDocument(doc);
+
+  return val;
+}
+
+
+
+static int Test_CheckOrder(JSON_Document* record, void* ctx)
+{
+  int64_t* next = ctx;
+
+  if (JSON_GetDictValue("i", record->root->dict)->integer != *next)
+    return 3;
+
+  ++*next;
+
+  return 0;
+}
+
+
+
+static int Test_SumRecord(JSON_Document* record, void* ctx)
+{
+  __atomic_fetch_add((int64_t*)ctx, JSON_GetDictValue("i", record->root->dict)->integer,
+                     __ATOMIC_RELAXED);
+
+  return 0;
+}
+
+
+
+static int Test_CountRecord(JSON_Document* record, void* ctx)
+{
+  if (record->root->type == JSON_LIST)
+    __atomic_fetch_add((int64_t*)ctx, record->root->list->index, __ATOMIC_RELAXED);
+
+  return 0;
+}
+
+
+
+void* Test_ParseLongRecord(void* arg)
+{
+  const size_t length = 300001;
+  const size_t full   = 8000;
+  const size_t lines  = 1000;
+
+  INIT_WORKER(val, "ParseLongRecord", "\0", 1);
+
+  char*  buf = malloc(length + 5 + 4 * (full + 4) * 4 + lines * 8);
+  size_t len = 0;
+
+  if (buf == NULL)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  /*  A string larger than a chunk of the arena, which the next records
+      reuse: a few fill it up to its end, with one byte strings, then
+      many short ones  */
+  buf[len++] = '[';
+  buf[len++] = '"';
+  memset(buf + len, 'a', length);
+  len += length;
+  memcpy(buf + len, "\"]\n", 3);
+  len += 3;
+
+  for (size_t k = 0; k < 4; ++k)
+  {
+    buf[len++] = '[';
+
+    for (size_t i = 0; i < full + k; ++i)
+      len += sprintf(buf + len, i ? ",\"b\"" : "\"b\"");
+
+    buf[len++] = ']';
+    buf[len++] = '\n';
+  }
+
+  for (size_t i = 0; i < lines; ++i)
+    len += sprintf(buf + len, "[\"%c\"]\n", (int)('a' + i % 26));
+
+  JSON_Document* doc    = JSON_MallocDocument();
+  FILE*          in     = fmemopen(buf, len, "r");
+  JSON_Reader*   reader = in ? JSON_MallocReader(in) : NULL;
+  int64_t        count  = 0;
+
+  if (doc == NULL || reader == NULL
+      || JSON_NextRecord(doc, reader, NULL, 4, 2) != 0
+      || strlen(doc->root->list->elements[0]->str) != length)
+    val->ok = 0;
+  else
+  {
+    for (size_t k = 0; k < 4; ++k)
+    {
+      if (JSON_NextRecord(doc, reader, NULL, 4, 2) != 0
+          || doc->root->list->index != full + k
+          || strcmp(doc->root->list->elements[full + k - 1]->str, "b") != 0)
+        val->ok = 0;
+    }
+
+    for (size_t i = 0; i < lines; ++i)
+    {
+      if (JSON_NextRecord(doc, reader, NULL, 4, 2) != 0
+          || doc->root->list->elements[0]->str[0] != (char)('a' + i % 26))
+        val->ok = 0;
+    }
+
+    if (JSON_NextRecord(doc, reader, NULL, 4, 2) != -1)
+      val->ok = 0;
+  }
+
+  JSON_FreeReader(reader);
+
+  if (in)
+    fclose(in);
+
+  JSON_FreeDocument(doc);
+
+  /*  Unordered, the document of a thread is reset after every record  */
+  JSON_Reader memory;
+
+  JSON_InitReader(&memory, buf, len);
+
+  if (JSON_ParseRecordsParallel(&memory, Test_CountRecord, &count, 1, 0, NULL, 4, 2) != 0
+      || count != (int64_t)(1 + 4 * full + 6 + lines))
+    val->ok = 0;
+
+  free(buf);
+
+  return val;
+}
+
+
+
+void* Test_ParseRecordsParallel(void* arg)
+{
+  const int64_t lines = 20000;
+  const int64_t bad   = 15000;
+
+  INIT_WORKER(val, "ParseRecordsParallel", "\0", 1);
+
+  char*  buf = malloc(lines * 16);
+  size_t len = 0;
+
+  if (buf == NULL)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  for (int64_t i = 0; i < lines; ++i)
+    len += sprintf(buf + len, i == 100 ? "\n{\"i\": %ld}\n" : "{\"i\": %ld}\n", (long)i);
+
+  JSON_Reader reader;
+  int64_t     next = 0;
+  int64_t     sum  = 0;
+
+  /*  In order, and in any order  */
+  JSON_InitReader(&reader, buf, len);
+
+  if (JSON_ParseRecordsParallel(&reader, Test_CheckOrder, &next, 4, 1, NULL, 4, 2) != 0
+      || next != lines)
+    val->ok = 0;
+
+  JSON_InitReader(&reader, buf, len);
+
+  if (JSON_ParseRecordsParallel(&reader, Test_SumRecord, &sum, 4, 0, NULL, 4, 2) != 0
+      || sum != lines * (lines - 1) / 2)
+    val->ok = 0;
+
+  /*  Every record before an invalid one, and none after  */
+  char* at = strstr(buf, "{\"i\": 15000}");
+
+  at[1] = '?';
+  next  = 0;
+
+  JSON_InitReader(&reader, buf, len);
+
+  if (JSON_ParseRecordsParallel(&reader, Test_CheckOrder, &next, 4, 1, NULL, 4, 2) != 1
+      || next != bad)
+    val->ok = 0;
+
+  free(buf);
+
+  return val;
+}
+
+
+
+void* Test_ParseArrayParallel(void* arg)
+{
+  const long elements = 20000;
+
+  INIT_WORKER(val, "ParseArrayParallel", "\0", 1);
+
+  char*  buf = malloc(elements * 32 + 2);
+  size_t len = 0;
+
+  if (buf == NULL)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  /*  Brackets and commas in strings don't cut an element  */
+  buf[len++] = '[';
+
+  for (long i = 0; i < elements; ++i)
+    len += sprintf(buf + len, "%s{\"i\": %ld, \"s\": \"],[\"}", i ? ",\n " : "", i);
+
+  buf[len++] = ']';
+
+  JSON_Reader reader;
+  type*       t = NULL;
+
+  JSON_InitReader(&reader, buf, len);
+
+  if (JSON_ParseArrayParallel(&t, &reader, 4, NULL, 4, 2) != 0 || t->list->index != elements)
+    val->ok = 0;
+  else
+  {
+    for (long i = 0; i < elements; ++i)
+    {
+      if (JSON_GetDictValue("i", t->list->elements[i]->dict)->integer != i)
+      {
+        val->ok = 0;
+        break;
+      }
+    }
+  }
+
+  JSON_FreeType(t);
+
+  /*  An invalid element in any chunk  */
+  buf[len / 2 + strcspn(buf + len / 2, "{") + 1] = '?';
+
+  JSON_InitReader(&reader, buf, len);
+
+  if (JSON_ParseArrayParallel(&t, &reader, 4, NULL, 4, 2) != 1 || t != NULL)
+    val->ok = 0;
+
+  free(buf);
+
+  return val;
+}
+
+
+
+void* Test_PushParse(void* arg)
+{
+  static char data[] = "{\"a\": [true, 1234, -5.5e-1], \"s\": \"x\\u00e9y\"}\n[null] [1,";
+
+  INIT_WORKER(val, "PushParse", "\0", 1);
+
+  JSON_PushParser* parser = JSON_MallocPushParser(NULL, 4, 2);
+  type*            t      = NULL;
+  int              retval = JSON_PUSH_MORE;
+  size_t           i      = 0;
+
+  if (parser == NULL)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  /*  One byte at a time: every token is cut  */
+  while (retval == JSON_PUSH_MORE && i < sizeof(data) - 1)
+    retval = JSON_PushParse(parser, data + i++, 1, &t);
+
+  if (retval != 0 || t == NULL || strcmp(JSON_GetDictValue("s", t->dict)->str, "x\xc3\xa9y") != 0
+      || JSON_GetDictValue("a", t->dict)->list->elements[1]->integer != 1234)
+    val->ok = 0;
+
+  JSON_FreeType(t);
+
+  /*  The next document is in the rest of the input  */
+  retval = JSON_PushParse(parser, data + i, sizeof(data) - 1 - i, &t);
+
+  if (retval != 0 || t == NULL || t->type != JSON_LIST)
+    val->ok = 0;
+
+  JSON_FreeType(t);
+
+  /*  Then one cut by the end of the input  */
+  if (JSON_PushParse(parser, NULL, 0, &t) != JSON_PUSH_MORE || JSON_PushEnd(parser, &t) != 1)
+    val->ok = 0;
+
+  /*  A failure resets the parser  */
+  if (JSON_PushParse(parser, "[1, }", 5, &t) != 1
+      || JSON_PushParse(parser, "[2]", 3, &t) != 0 || t->list->elements[0]->integer != 2)
+    val->ok = 0;
+
+  JSON_FreeType(t);
+
+  /*  A long string one byte at a time, with its escaped quotes and
+      backslashes cut from what they escape  */
+  size_t n        = 1000;
+  char*  input    = malloc(6 * n + 5);
+  char*  expected = malloc(4 * n + 1);
+
+  if (input == NULL || expected == NULL)
+  {
+    val->ok = 0;
+  }
+  else
+  {
+    strcpy(input, "[\"");
+
+    for (size_t k = 0; k < n; ++k)
+    {
+      strcat(input + 2 + 6 * k, "a\\\"b\\\\");
+      memcpy(expected + 4 * k, "a\"b\\", 4);
+    }
+
+    strcat(input + 2 + 6 * n, "\"]");
+    expected[4 * n] = '\0';
+
+    retval = JSON_PUSH_MORE;
+
+    for (i = 0; retval == JSON_PUSH_MORE && input[i]; ++i)
+      retval = JSON_PushParse(parser, input + i, 1, &t);
+
+    if (retval != 0 || input[i] != '\0' || t == NULL
+        || strcmp(t->list->elements[0]->str, expected) != 0)
+      val->ok = 0;
+
+    JSON_FreeType(t);
+  }
+
+  free(input);
+  free(expected);
+
+  /*  Dropped while a document is open  */
+  JSON_PushParse(parser, "{\"k\": [\"v\"", 10, &t);
+  JSON_FreePushParser(parser);
+
+  return val;
+}
+
+
+
+/**
+ * @brief Print the tree parsed by an engine, after its return value.
+ */
+static char* Test_PrintEngine(int descent, const char* data, JSON_Document* doc)
+{
+  JSON_Reader reader;
+  type*       t   = NULL;
+  char*       out = NULL;
+  size_t      len = 0;
+  int         retval;
+
+  JSON_InitReader(&reader, data, strlen(data));
+
+  if (doc)
+  {
+    JSON_ResetDocument(doc);
+    retval = descent ? JSON_DescentParse(&doc->root, &reader, NULL, 4, 2, &doc->alloc, doc->keys)
+                     : JSON_yyparse(&doc->root, &reader, NULL, 4, 2, &doc->alloc, doc->keys);
+    t = doc->root;
+  }
+  else
+  {
+    retval = descent ? JSON_DescentParse(&t, &reader, NULL, 4, 2, &JSON_DefaultAllocator, NULL)
+                     : JSON_yyparse(&t, &reader, NULL, 4, 2, &JSON_DefaultAllocator, NULL);
+  }
+
+  FILE* fd = open_memstream(&out, &len);
+
+  fprintf(fd, "%d ", retval);
+
+  if (retval == 0 && t)
+    JSON_PrintType(t, fd);
+
+  fclose(fd);
+
+  /*  Bison keeps the tree before trailing input  */
+  if (doc == NULL)
+    JSON_FreeType(t);
+
+  return out;
+}
+
+
+
+void* Test_DescentParse(void* arg)
+{
+  static const char* data[] =
+  {
+    "{\"a\": [1, -2.5e3, {\"b\": \"x\\u00e9\"}, [[true]]], \"c\": null, \"a\": false}",
+    "[{\"k\": 1, \"l\": 2}, {\"k\": 3, \"l\": 4}, {\"k\": 5, \"k\": 6}]",
+    "",
+    "{}",
+    "[1, ]",
+    "{\"a\" 1}",
+    "[1] 2",
+    "[\"x\", {\"y\": [1}]",
+  };
+
+  INIT_WORKER(val, "DescentParse", "\0", 1);
+
+  JSON_Document* doc = JSON_MallocDocument();
+
+  if (doc == NULL)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  /*  The same trees as the Bison parser, with and without interned labels  */
+  for (size_t i = 0; i < sizeof(data) / sizeof(data[0]); ++i)
+  {
+    for (int interned = 0; interned < 2; ++interned)
+    {
+      char* bison   = Test_PrintEngine(0, data[i], interned ? doc : NULL);
+      char* descent = Test_PrintEngine(1, data[i], interned ? doc : NULL);
+
+      if (strcmp(bison, descent) != 0)
+        val->ok = 0;
+
+      free(bison);
+      free(descent);
+    }
+  }
+
+  JSON_FreeDocument(doc);
+
+  /*  Nothing left on failure, with the default engine too  */
+  type* t = NULL;
+
+  if (JSON_ParseBuffer(&t, "[1] x", 5, NULL, 4, 2) != 1 || t != NULL)
+    val->ok = 0;
+
+  return val;
+}
+
+
+
+void* Test_ParseTape(void* arg)
+{
+  static char data[] = "{\"a\": [1, -2.5, \"x\", true, null, {\"f\": 0}, [0]],"
+                       " \"b\": {\"c\": \"d\\n\"}, \"e\": 18446744073709551615}";
+
+  INIT_WORKER(val, "ParseTape", "\0", 1);
+
+  JSON_Tape* tape = JSON_MallocTape();
+
+  if (tape == NULL || JSON_ParseTapeBuffer(tape, data, strlen(data)))
+  {
+    JSON_FreeTape(tape);
+    val->ok = 0;
+    return val;
+  }
+
+  size_t root = JSON_TapeRoot(tape);
+  size_t a    = JSON_TapeGet(tape, root, "a");
+  size_t c    = JSON_TapeGet(tape, JSON_TapeGet(tape, root, "b"), "c");
+  size_t e    = JSON_TapeGet(tape, root, "e");
+
+  if (JSON_TapeType(tape, root) != JSON_DICT || JSON_TapeSize(tape, root) != 3
+      || JSON_TapeSize(tape, a) != 7 || JSON_TapeGet(tape, root, "z") != 0)
+    val->ok = 0;
+
+  else if (JSON_TapeInteger(tape, JSON_TapeAt(tape, a, 0)) != 1
+           || JSON_TapeNumber(tape, JSON_TapeAt(tape, a, 1)) != -2.5
+           || strcmp(JSON_TapeString(tape, JSON_TapeAt(tape, a, 2)), "x") != 0
+           || JSON_TapeBool(tape, JSON_TapeAt(tape, a, 3)) != 1
+           || JSON_TapeBool(tape, JSON_TapeAt(tape, a, 4)) != 0
+           || JSON_TapeSize(tape, JSON_TapeAt(tape, a, 5)) != 1
+           || JSON_TapeType(tape, JSON_TapeAt(tape, a, 6)) != JSON_LIST
+           || JSON_TapeAt(tape, a, 7) != 0)
+    val->ok = 0;
+
+  else if (strcmp(JSON_TapeString(tape, c), "d\n") != 0
+           || strcmp(JSON_TapeLabel(tape, c), "c") != 0
+           || JSON_TapeUnsigned(tape, e) != UINT64_MAX)
+    val->ok = 0;
+
+  /*  Invalid input leaves an empty tape  */
+  if (JSON_ParseTapeBuffer(tape, "[1, }", 5) != 1 || JSON_TapeRoot(tape) != 0)
+    val->ok = 0;
+
+  /*  Rejected by the parsers, so by the tape  */
+  static const char* rejected[] =
+  {
+    "{}", "[]", "1", "\"s\"", "true", "[[]]", "[1, {}]", "{\"a\": []}"
+  };
+
+  for (size_t i = 0; i < sizeof(rejected) / sizeof(*rejected); ++i)
+  {
+    type* t = NULL;
+
+    if (JSON_ParseBuffer(&t, rejected[i], strlen(rejected[i]), NULL, 4, 2) != 1
+        || JSON_ParseTapeBuffer(tape, rejected[i], strlen(rejected[i])) != 1
+        || JSON_TapeRoot(tape) != 0)
+      val->ok = 0;
+  }
+
+  /*  Empty input is no value  */
+  if (JSON_ParseTapeBuffer(tape, " ", 1) != 0 || JSON_TapeRoot(tape) != 0)
+    val->ok = 0;
+
+  JSON_FreeTape(tape);
+
+  return val;
+}
+
+
+
+void* Test_Cursor(void* arg)
+{
+  static char data[] = " {\"skip\": {\"x\": [\"}\\\"]\", {}]}, \"a\\u0062\": [true, -3, \"s\\n\"],"
+                       " \"n\": 2.5, \"o\": {\"k\": 1}}";
+
+  JSON_Cursor root;
+  JSON_Cursor ab;
+  JSON_Cursor value;
+  JSON_Number number;
+  int         bool;
+
+  INIT_WORKER(val, "Cursor", "\0", 1);
+
+  if (JSON_OpenCursor(&root, data, strlen(data)) != 0 || JSON_CursorType(&root) != JSON_DICT)
+  {
+    val->ok = 0;
+    return val;
+  }
+
+  /*  Escaped label, after a skipped dict with brackets in a string  */
+  if (JSON_CursorGet(&root, "ab", &ab) != 0 || JSON_CursorType(&ab) != JSON_LIST
+      || JSON_CursorGet(&root, "missing", &value) == 0)
+    val->ok = 0;
+
+  else if (JSON_CursorAt(&ab, 0, &value) != 0 || JSON_CursorBool(&value, &bool) != 0 || bool != 1
+           || JSON_CursorAt(&ab, 1, &value) != 0 || JSON_CursorNumber(&value, &number) != 0
+           || number.type != JSON_INTEGER || number.integer != -3
+           || JSON_CursorAt(&ab, 3, &value) == 0)
+    val->ok = 0;
+
+  else
+  {
+    char* str = JSON_CursorAt(&ab, 2, &value) == 0 ? JSON_CursorString(&value) : NULL;
+
+    if (str == NULL || strcmp(str, "s\n") != 0)
+      val->ok = 0;
+
+    free(str);
+
+    /*  A string isn't a number nor a bool  */
+    if (JSON_CursorNumber(&value, &number) == 0 || JSON_CursorBool(&value, &bool) == 0)
+      val->ok = 0;
+  }
+
+  /*  A subtree parsed on demand  */
+  type* o = JSON_CursorGet(&root, "o", &value) == 0 ? JSON_CursorValue(&value) : NULL;
+
+  if (o == NULL || o->type != JSON_DICT || JSON_GetDictValue("k", o->dict)->integer != 1)
+    val->ok = 0;
+
+  JSON_FreeType(o);
+
+  return val;
+}
+
+
+
+static int Test_CountStartDict(void* ctx)
+{
+  ++((int*)ctx)[0];
+  return 0;
+}
+
+
+
+static int Test_CountStartList(void* ctx)
+{
+  ++((int*)ctx)[1];
+  return 0;
+}
+
+
+
+static int Test_CountKey(void* ctx, char* label, size_t len)
+{
+  ++((int*)ctx)[2];
+  return 0;
+}
+
+
+
+static int Test_CountString(void* ctx, char* str, size_t len)
+{
+  ((int*)ctx)[3] += strcmp(str, "x") == 0 && len == 1;
+  return 0;
+}
+
+
+
+static int Test_CountNumber(void* ctx, const JSON_Number* num)
+{
+  ++((int*)ctx)[4];
+  return 0;
+}
+
+
+
+static int Test_CountBoolean(void* ctx, int value)
+{
+  ++((int*)ctx)[5];
+  return 0;
+}
+
+
+
+void* Test_ParseEvents(void* arg)
+{
+  static char data[] = "{\"a\": [1, {\"b\": \"x\"}, [2], true], \"c\": {\"d\": 3},"
+                       " \"a\": null}";
+
+  int counts[8] = {0};
+
+  INIT_WORKER(val, "ParseEvents", "\0", 1);
+
+  /*  Count the events, with strings in the scratch buffer  */
+  JSON_Handler handler =
+  {
+    .start_dict = Test_CountStartDict,
+    .start_list = Test_CountStartList,
+    .key        = Test_CountKey,
+    .string     = Test_CountString,
+    .number     = Test_CountNumber,
+    .boolean    = Test_CountBoolean,
+    .ctx        = counts,
+  };
+
+  JSON_Reader reader;
+
+  JSON_InitReader(&reader, data, strlen(data));
+
+  if (JSON_ParseEvents(&reader, &handler) != 0
+      || counts[0] != 3 || counts[1] != 2 || counts[2] != 5
+      || counts[3] != 1 || counts[4] != 3 || counts[5] != 2)
+    val->ok = 0;
+
+  /*  A truncated input  */
+  JSON_InitReader(&reader, data, 10);
+
+  if (JSON_ParseEvents(&reader, &handler) != 1)
+    val->ok = 0;
+
+  /*  Rejected by the parsers, so by the events  */
+  static const char* rejected[] =
+  {
+    "{}", "[]", "1", "\"s\"", "null", "[[]]", "[1, {}]", "{\"a\": []}"
+  };
+
+  for (size_t i = 0; i < sizeof(rejected) / sizeof(*rejected); ++i)
+  {
+    type* t = NULL;
+
+    JSON_InitReader(&reader, rejected[i], strlen(rejected[i]));
+
+    if (JSON_ParseBuffer(&t, rejected[i], strlen(rejected[i]), NULL, 4, 2) != 1
+        || JSON_ParseEvents(&reader, &handler) != 1)
+      val->ok = 0;
+  }
+
+  /*  The same tree as the Bison parser, the last duplicate label wins  */
+  type* built = NULL;
+
+  JSON_InitReader(&reader, data, strlen(data));
+
+  if (JSON_BuildReader(&built, &reader, NULL, NULL, JSON_DICT_MIN_SIZE, 4) != 0
+      || built == NULL || built->type != JSON_DICT
+      || JSON_GetDictValue("a", built->dict)->type != JSON_BOOLEAN
+      || JSON_GetDictValue("c", built->dict)->type != JSON_DICT)
+    val->ok = 0;
+
+  JSON_FreeType(built);
+
+  /*  Nothing to release on failure  */
+  JSON_InitReader(&reader, "[1, {\"k\": 2", 12);
+
+  if (JSON_BuildReader(&built, &reader, NULL, NULL, JSON_DICT_MIN_SIZE, 4) != 1
+      || built != NULL)
+    val->ok = 0;
+
+  return val;
+}
+
+
+
+/*  The context is the number of live blocks, then of allocations  */
+static void* Test_CountAlloc(void* ctx, size_t size)
+{
+  ++((long*)ctx)[0];
+  ++((long*)ctx)[1];
+  return malloc(size);
+}
+
+
+
+static void* Test_CountRealloc(void* ctx, void* ptr, size_t old, size_t size)
+{
+  if (ptr == NULL)
+  {
+    ++((long*)ctx)[0];
+    ++((long*)ctx)[1];
+  }
+
+  return realloc(ptr, size);
+}
+
+
+
+static void Test_CountFree(void* ctx, void* ptr)
+{
+  if (ptr)
+    --((long*)ctx)[0];
+
+  free(ptr);
+}
+
+
+
+void* Test_ParseAllocator(void* arg)
+{
+  static char data[] = "{\"a\": [1, 2, 3, \"x\"], \"b\": {\"c\": \"y\"}, \"a\": null}";
+
+  long counts[2] = {0, 0};
+
+  JSON_Allocator alloc = {Test_CountAlloc, Test_CountRealloc, Test_CountFree, counts};
+
+  JSON_Reader reader;
+  type*       t = NULL;
+
+  INIT_WORKER(val, "ParseAllocator", "\0", 1);
+
+  JSON_InitReader(&reader, data, strlen(data));
+
+  if (JSON_ParseReaderWith(&t, &reader, &alloc, Test_Hash, 4, 2) || counts[0] == 0)
+    val->ok = 0;
+
+  /*  A scalar is freed without allocating  */
+  type* scalar = JSON_MallocTypeWith(&alloc, "s", JSON_BOOLEAN);
+  long  allocs = counts[1];
+
+  JSON_FreeTypeWith(&alloc, scalar);
+
+  if (counts[1] != allocs)
+    val->ok = 0;
+
+  JSON_FreeTypeWith(&alloc, t);
+
+  /*  Everything went through the allocator  */
+  if (counts[0] != 0)
+    val->ok = 0;
+
+  /*  More containers than the stack of JSON_FreeTypeWith() holds, it
+      grows with the allocator  */
+  char   wide[2 + 100 * 4];
+  size_t len = 0;
+
+  for (int i = 0; i < 100; ++i)
+    len += sprintf(wide + len, "%s[1]", i ? "," : "[");
+
+  wide[len++] = ']';
+
+  JSON_InitReader(&reader, wide, len);
+
+  if (JSON_ParseReaderWith(&t, &reader, &alloc, Test_Hash, 4, 2) != 0)
+    val->ok = 0;
+
+  allocs = counts[1];
+
+  JSON_FreeTypeWith(&alloc, t);
+
+  if (counts[0] != 0 || counts[1] != allocs + 1)
+    val->ok = 0;
+
+  return val;
+}
+#endif // _JSON_TEST_PARSER_H
@@ -33,7 +33,9 @@
 /*=============================================================================+
  |                               Includes Tests                                |
  +=============================================================================*/
+#include "test-dict.h"
 #include "test-list.h"
+#include "test-parser.h"
 
 
 
@@ -43,6 +45,30 @@ JSON_Tester tests[] =
   TEST(test_list2),
   TEST(Test_InsertList),
   TEST(test_list3),
+  TEST(Test_ParseStream),
+  TEST(Test_ParseEscapes),
+  TEST(Test_ParseNumbers),
+  TEST(Test_ParseIntegers),
+  TEST(Test_IndexParse),
+  TEST(Test_ParseFile),
+  TEST(Test_ParseDocument),
+  TEST(Test_ArenaReuse),
+  TEST(Test_InternKeys),
+  TEST(Test_ParseInSitu),
+  TEST(Test_ParseRecords),
+  TEST(Test_ParseLongRecord),
+  TEST(Test_ParseRecordsParallel),
+  TEST(Test_ParseArrayParallel),
+  TEST(Test_PushParse),
+  TEST(Test_DescentParse),
+  TEST(Test_ParseTape),
+  TEST(Test_Cursor),
+  TEST(Test_ParseEvents),
+  TEST(Test_ParseAllocator),
+  TEST(Test_GrowDict),
+  TEST(Test_OpenDict),
+  TEST(Test_DefaultHash),
+  TEST(Test_OrderDict),
   {NULL}
 };
 #endif // _JSON_TEST_TO_INCLUDE_H